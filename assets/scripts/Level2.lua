@@ -90,6 +90,15 @@ Level = {
         scale = 2.0
     },
 
+    ----------------------------------------------------
+    -- entities farther than distance (in pixels) from the camera view go
+    -- to sleep, and wake up again once they are within wake_distance
+    ----------------------------------------------------
+    sleep = {
+        distance = 600,
+        wake_distance = 400
+    },
+
     ----------------------------------------------------
     -- table to define entities and their components
     ----------------------------------------------------
@@ -1,6 +1,7 @@
 #include "AssetStore.h"
 #include "../Logger/Logger.h"
 #include <SDL2/SDL_image.h>
+#include <memory>
 
 AssetStore::AssetStore()
 {
@@ -43,6 +44,24 @@ void AssetStore::AddTexture(SDL_Renderer *renderer, const std::string &assetId,
     Logger::Log("Texture " + assetId + " added.");
 }
 
+JobHandle AssetStore::AddTextureAsync(JobSystem& jobSystem, SDL_Renderer* renderer, const std::string& assetId, const std::string& filePath)
+{
+    auto surface = std::make_shared<SDL_Surface*>(nullptr);
+
+    JobHandle decode = jobSystem.Schedule([surface, filePath]() {
+        *surface = IMG_Load(filePath.c_str());
+    });
+
+    return jobSystem.ScheduleOnMainThread([this, surface, renderer, assetId]() {
+        SDL_Texture *texture = SDL_CreateTextureFromSurface(renderer, *surface);
+        SDL_FreeSurface(*surface);
+
+        textures.emplace(assetId, texture);
+
+        Logger::Log("Texture " + assetId + " added.");
+    }, {decode});
+}
+
 SDL_Texture *AssetStore::GetTexture(const std::string &assetId)
 {
     return textures[assetId];
@@ -4,6 +4,7 @@
 #include <map>
 #include <SDL2/SDL.h>
 #include <SDL2/SDL_ttf.h>
+#include "../Jobs/JobSystem.h"
 
 class AssetStore {
     private:
@@ -15,6 +16,8 @@ class AssetStore {
 
         void ClearAssets();
         void AddTexture(SDL_Renderer* renderer, const std::string& assetId, const std::string& filePath);
+        // Decodes the image on a worker; the texture is created on the main thread once it's done
+        JobHandle AddTextureAsync(JobSystem& jobSystem, SDL_Renderer* renderer, const std::string& assetId, const std::string& filePath);
         SDL_Texture* GetTexture(const std::string& assetId);
 
         void AddFont(const std::string& assetId, const std::string& filePath, int fontSize);
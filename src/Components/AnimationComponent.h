@@ -1,8 +1,11 @@
 #pragma once
 
 #include <SDL2/SDL.h>
+#include "ComponentIds.h"
 
 struct AnimationComponent {
+    static constexpr int StaticId = ANIMATION_COMPONENT_ID;
+
     int numFrames;
     int currentFrame;
     int frameSpeedRate;
@@ -1,8 +1,11 @@
 #pragma once
 
 #include <glm/glm.hpp>
+#include "ComponentIds.h"
 
 struct BoxColliderComponent {
+    static constexpr int StaticId = BOX_COLLIDER_COMPONENT_ID;
+
     int width;
     int height;
     glm::vec2 offset;
@@ -1,5 +1,9 @@
 #pragma once
 
+#include "ComponentIds.h"
+
 struct CameraFollowComponent {
+    static constexpr int StaticId = CAMERA_FOLLOW_COMPONENT_ID;
+
     CameraFollowComponent() = default;
 };
@@ -0,0 +1,20 @@
+#pragma once
+
+// Compile-time ids of the engine's components (see Component<T>::GetId).
+// They don't depend on first-use order, so they stay the same across builds and runs
+// and can be stored in serialized data: only append new ids, never reorder or reuse them.
+enum ComponentIds {
+    TRANSFORM_COMPONENT_ID = 0,
+    RIGID_BODY_COMPONENT_ID = 1,
+    SPRITE_COMPONENT_ID = 2,
+    ANIMATION_COMPONENT_ID = 3,
+    BOX_COLLIDER_COMPONENT_ID = 4,
+    KEYBOARD_CONTROLLED_COMPONENT_ID = 5,
+    CAMERA_FOLLOW_COMPONENT_ID = 6,
+    PROJECTILE_EMITTER_COMPONENT_ID = 7,
+    PROJECTILE_COMPONENT_ID = 8,
+    HEALTH_COMPONENT_ID = 9,
+    TEXT_LABEL_COMPONENT_ID = 10,
+    SCRIPT_COMPONENT_ID = 11,
+    SLEEP_COMPONENT_ID = 12
+};
@@ -1,6 +1,10 @@
 #pragma once
 
+#include "ComponentIds.h"
+
 struct HealthComponent {
+    static constexpr int StaticId = HEALTH_COMPONENT_ID;
+
     int healthPercentage;
 
     HealthComponent(int healthPercentage = 0) {
@@ -1,8 +1,11 @@
 #pragma once
 
 #include <glm/glm.hpp>
+#include "ComponentIds.h"
 
 struct KeyboardControlledComponent {
+    static constexpr int StaticId = KEYBOARD_CONTROLLED_COMPONENT_ID;
+
     glm::vec2 upVelocity;
     glm::vec2 rightVelocity;
     glm::vec2 downVelocity;
@@ -1,8 +1,11 @@
 #pragma once
 
 #include <SDL2/SDL.h>
+#include "ComponentIds.h"
 
 struct ProjectileComponent {
+    static constexpr int StaticId = PROJECTILE_COMPONENT_ID;
+
     bool isFriendly;
     int hitPercentDamage;
     uint32_t duration;
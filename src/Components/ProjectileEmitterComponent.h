@@ -2,8 +2,11 @@
 
 #include <glm/glm.hpp>
 #include <SDL2/SDL.h>
+#include "ComponentIds.h"
 
 struct ProjectileEmitterComponent {
+    static constexpr int StaticId = PROJECTILE_EMITTER_COMPONENT_ID;
+
     glm::vec2 velocity;
     uint32_t repeatFrequency;
     int duration;
@@ -1,8 +1,11 @@
 #pragma once
 
 #include <glm/glm.hpp>
+#include "ComponentIds.h"
 
 struct RigidBodyComponent {
+    static constexpr int StaticId = RIGID_BODY_COMPONENT_ID;
+
     glm::vec2 velocity;
 
     RigidBodyComponent(glm::vec2 velocity = glm::vec2(0.0, 0.0)) {
@@ -1,8 +1,11 @@
 #pragma once
 
 #include <sol/sol.hpp>
+#include "ComponentIds.h"
 
 struct ScriptComponent {
+    static constexpr int StaticId = SCRIPT_COMPONENT_ID;
+
     sol::function func;
 
     ScriptComponent(sol::function func = sol::lua_nil) {
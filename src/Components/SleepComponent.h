@@ -0,0 +1,17 @@
+#pragma once
+
+#include "ComponentIds.h"
+
+// Lets the entity sleep while it's far from the camera view (see SleepSystem).
+// wakeDistance is below sleepDistance, so an entity near the limit doesn't flip every check.
+struct SleepComponent {
+    static constexpr int StaticId = SLEEP_COMPONENT_ID;
+
+    double sleepDistance;
+    double wakeDistance;
+
+    SleepComponent(double sleepDistance = 0.0, double wakeDistance = 0.0) {
+        this->sleepDistance = sleepDistance;
+        this->wakeDistance = wakeDistance;
+    }
+};
@@ -2,15 +2,26 @@
 
 #include <string>
 #include <SDL2/SDL.h>
+#include "ComponentIds.h"
+#include "../ECS/Shared.h"
 
-struct SpriteComponent
+// The part of a sprite entities drawing the same image have in common
+struct SpriteData
 {
     std::string assetId;
-    int width;
-    int height;
-    int zIndex;
+    int width = 0;
+    int height = 0;
+    int zIndex = 0;
+    bool isFixed = false;
+};
+
+struct SpriteComponent
+{
+    static constexpr int StaticId = SPRITE_COMPONENT_ID;
+
+    // Shared with every sprite created from the same handle; change it through data.Write()
+    Shared<SpriteData> data;
     SDL_RendererFlip flip;
-    bool isFixed;
     SDL_Rect srcRect;
 
     SpriteComponent(
@@ -20,14 +31,15 @@ struct SpriteComponent
         int zIndex = 0,
         bool isFixed = false,
         int srcRectX = 0,
-        int srcRectY = 0)
+        int srcRectY = 0):
+        SpriteComponent(Shared<SpriteData>::Make(assetId, width, height, zIndex, isFixed), srcRectX, srcRectY)
+    {
+    }
+
+    SpriteComponent(Shared<SpriteData> data, int srcRectX = 0, int srcRectY = 0)
     {
-        this->assetId = assetId;
-        this->width = width;
-        this->height = height;
-        this->zIndex = zIndex;
+        this->data = data;
         this->flip = SDL_FLIP_NONE;
-        this->isFixed = isFixed;
-        this->srcRect = {srcRectX, srcRectY, width, height};
+        this->srcRect = {srcRectX, srcRectY, data->width, data->height};
     }
 };
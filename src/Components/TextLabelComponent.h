@@ -2,8 +2,11 @@
 
 #include <SDL2/SDL.h>
 #include <glm/glm.hpp>
+#include "ComponentIds.h"
 
 struct TextLabelComponent {
+    static constexpr int StaticId = TEXT_LABEL_COMPONENT_ID;
+
     glm::vec2 position;
     std::string text;
     std::string assetId;
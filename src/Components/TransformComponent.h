@@ -1,8 +1,11 @@
 #pragma once
 
 #include <glm/glm.hpp>
+#include "ComponentIds.h"
 
 struct TransformComponent {
+    static constexpr int StaticId = TRANSFORM_COMPONENT_ID;
+
     glm::vec2 position;
     glm::vec2 scale;
     double rotation;
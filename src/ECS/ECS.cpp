@@ -2,46 +2,94 @@
 #include <algorithm>
 #include "../Logger/Logger.h"
 
-int IComponent::nextId = 0;
+int IComponent::nextId = NUM_STATIC_COMPONENT_IDS;
 
-int Entity::GetId() const
-{
-    return id;
-}
+Registry* Registry::current = nullptr;
+thread_local CommandBuffer* CommandBuffer::active = nullptr;
+std::unordered_map<std::string, int> Registry::tagIds;
+std::unordered_map<std::string, int> Registry::groupIds;
 
 void Entity::Kill() {
-    registry->KillEntity(*this);
+    Registry::GetCurrent()->KillEntity(*this);
+}
+
+void Entity::Disable() {
+    Registry::GetCurrent()->DisableEntity(*this);
+}
+
+void Entity::Enable() {
+    Registry::GetCurrent()->EnableEntity(*this);
+}
+
+bool Entity::IsEnabled() const {
+    return Registry::GetCurrent()->IsEntityEnabled(*this);
+}
+
+bool Entity::IsAlive() const {
+    return Registry::GetCurrent()->IsAlive(*this);
 }
 
 void Entity::Tag(const std::string& tag) {
-	registry->TagEntity(*this, tag);
+	Registry::GetCurrent()->TagEntity(*this, tag);
 }
 
 bool Entity::HasTag(const std::string& tag) const {
-	return registry->EntityHasTag(*this, tag);
+	return Registry::GetCurrent()->EntityHasTag(*this, tag);
+}
+
+bool Entity::HasTag(int tagId) const {
+	return Registry::GetCurrent()->EntityHasTag(*this, tagId);
 }
 
 void Entity::Group(const std::string& group) {
-	registry->GroupEntity(*this, group);
+	Registry::GetCurrent()->GroupEntity(*this, group);
 }
 
 bool Entity::BelongsToGroup(const std::string& group) const {
-	return registry->EntityBelongsToGroup(*this, group);
+	return Registry::GetCurrent()->EntityBelongsToGroup(*this, group);
+}
+
+bool Entity::BelongsToGroup(int groupId) const {
+	return Registry::GetCurrent()->EntityBelongsToGroup(*this, groupId);
 }
 
 void System::AddEntity(Entity entity)
 {
+    const int entityId = entity.GetId();
+    if (entityId >= static_cast<int>(entityIndices.size())) {
+        entityIndices.resize(entityId + 1, -1);
+    }
+    if (entityIndices[entityId] != -1) {
+        return;
+    }
+
+    entityIndices[entityId] = static_cast<int>(entities.size());
     entities.push_back(entity);
 }
 
 void System::RemoveEntity(Entity entity)
 {
-    entities.erase(std::remove_if(entities.begin(), entities.end(), [&entity](Entity other)
-                                  { return entity == other; }),
-                   entities.end());
+    if (!HasEntity(entity)) {
+        return;
+    }
+
+    // Swap-and-pop: move the last entity into the hole
+    const int indexOfRemoved = entityIndices[entity.GetId()];
+    const Entity last = entities.back();
+    entities[indexOfRemoved] = last;
+    entityIndices[last.GetId()] = indexOfRemoved;
+
+    entities.pop_back();
+    entityIndices[entity.GetId()] = -1;
+}
+
+bool System::HasEntity(Entity entity) const
+{
+    const int entityId = entity.GetId();
+    return entityId < static_cast<int>(entityIndices.size()) && entityIndices[entityId] != -1;
 }
 
-std::vector<Entity> System::GetEntities() const
+const std::vector<Entity>& System::GetEntities() const
 {
     return entities;
 }
@@ -51,136 +99,740 @@ const Signature &System::GetSignature() const
     return componentSignature;
 }
 
+Archetype::Archetype(const Signature& signature, const std::vector<ComponentInfo>& componentInfos): signature(signature) {
+    columnOfComponent.assign(MAX_COMPONENTS, -1);
+    signature.ForEach([&](int componentId) {
+        columnOfComponent[componentId] = static_cast<int>(columnInfos.size());
+        columnInfos.push_back(componentInfos[componentId]);
+    });
+
+    size_t bytesPerEntity = sizeof(int);
+    for (const auto& info: columnInfos) {
+        bytesPerEntity += info.size;
+    }
+
+    // Fit as many rows as possible in a chunk, leaving room to align every column
+    chunkCapacity = std::max(1, static_cast<int>(ARCHETYPE_CHUNK_SIZE / bytesPerEntity));
+    while (true) {
+        size_t offset = sizeof(int) * chunkCapacity;
+        columnOffsets.clear();
+        for (const auto& info: columnInfos) {
+            offset = (offset + info.alignment - 1) / info.alignment * info.alignment;
+            columnOffsets.push_back(offset);
+            offset += info.size * chunkCapacity;
+        }
+        if (offset <= ARCHETYPE_CHUNK_SIZE || chunkCapacity == 1) {
+            break;
+        }
+        chunkCapacity--;
+    }
+}
+
+Archetype::~Archetype() {
+    for (auto& chunk: chunks) {
+        for (int row = 0; row < chunk.count; row++) {
+            for (size_t column = 0; column < columnInfos.size(); column++) {
+                columnInfos[column].destroy(chunk.memory + columnOffsets[column] + row * columnInfos[column].size);
+            }
+        }
+        ::operator delete(chunk.memory, std::align_val_t(ARCHETYPE_CHUNK_ALIGNMENT));
+    }
+}
+
+int Archetype::GetSize() const {
+    int size = 0;
+    for (const auto& chunk: chunks) {
+        size += chunk.count;
+    }
+    return size;
+}
+
+void Archetype::AllocateRow(int entityId, int& chunk, int& row) {
+    if (chunks.empty() || chunks.back().count == chunkCapacity) {
+        ArchetypeChunk newChunk;
+        newChunk.memory = static_cast<unsigned char*>(::operator new(GetChunkBytes(), std::align_val_t(ARCHETYPE_CHUNK_ALIGNMENT)));
+        chunks.push_back(newChunk);
+    }
+
+    chunk = static_cast<int>(chunks.size()) - 1;
+    row = chunks.back().count++;
+    reinterpret_cast<int*>(chunks.back().memory)[row] = entityId;
+}
+
+int Archetype::RemoveRow(int chunk, int row) {
+    for (size_t column = 0; column < columnInfos.size(); column++) {
+        columnInfos[column].destroy(GetSlot(chunk, row, column));
+    }
+
+    const int lastChunk = static_cast<int>(chunks.size()) - 1;
+    const int lastRow = chunks[lastChunk].count - 1;
+    int movedEntityId = -1;
+
+    if (chunk != lastChunk || row != lastRow) {
+        for (size_t column = 0; column < columnInfos.size(); column++) {
+            void* last = GetSlot(lastChunk, lastRow, column);
+            columnInfos[column].moveConstruct(GetSlot(chunk, row, column), last);
+            columnInfos[column].destroy(last);
+        }
+        movedEntityId = GetEntityIds(lastChunk)[lastRow];
+        reinterpret_cast<int*>(chunks[chunk].memory)[row] = movedEntityId;
+    }
+
+    if (--chunks[lastChunk].count == 0) {
+        ::operator delete(chunks[lastChunk].memory, std::align_val_t(ARCHETYPE_CHUNK_ALIGNMENT));
+        chunks.pop_back();
+    }
+
+    return movedEntityId;
+}
+
+Archetype* ArchetypeStorage::GetOrCreateArchetype(const Signature& signature) {
+    auto archetype = archetypesBySignature.find(signature);
+    if (archetype != archetypesBySignature.end()) {
+        return archetype->second.get();
+    }
+
+    auto newArchetype = std::make_unique<Archetype>(signature, componentInfos);
+    Archetype* newArchetypePtr = newArchetype.get();
+    archetypesBySignature.emplace(signature, std::move(newArchetype));
+    archetypes.push_back(newArchetypePtr);
+    return newArchetypePtr;
+}
+
+ArchetypeStorage::EntityLocation& ArchetypeStorage::GetLocation(int entityId) {
+    if (entityId >= static_cast<int>(locations.size())) {
+        locations.resize(entityId + 1);
+    }
+    return locations[entityId];
+}
+
+// Moves the entity's row to the archetype of the new signature, carrying over the components both share.
+// Components that aren't part of the new signature are destroyed; new ones are left for the caller to construct.
+void ArchetypeStorage::MoveEntity(int entityId, const Signature& newSignature) {
+    EntityLocation oldLocation = GetLocation(entityId);
+    EntityLocation newLocation;
+
+    if (newSignature.any()) {
+        newLocation.archetype = GetOrCreateArchetype(newSignature);
+        newLocation.archetype->AllocateRow(entityId, newLocation.chunk, newLocation.row);
+
+        if (oldLocation.archetype) {
+            const Signature sharedComponents = newSignature & oldLocation.archetype->GetSignature();
+            sharedComponents.ForEach([&](int componentId) {
+                componentInfos[componentId].moveConstruct(
+                    newLocation.archetype->GetComponent(newLocation.chunk, newLocation.row, newLocation.archetype->GetColumn(componentId)),
+                    oldLocation.archetype->GetComponent(oldLocation.chunk, oldLocation.row, oldLocation.archetype->GetColumn(componentId))
+                );
+            });
+        }
+    }
+
+    if (oldLocation.archetype) {
+        const int movedEntityId = oldLocation.archetype->RemoveRow(oldLocation.chunk, oldLocation.row);
+        if (movedEntityId != -1) {
+            locations[movedEntityId].chunk = oldLocation.chunk;
+            locations[movedEntityId].row = oldLocation.row;
+        }
+    }
+
+    locations[entityId] = newLocation;
+}
+
+void ArchetypeStorage::AddEntities(int firstEntityId, int count, const Signature& signature) {
+    if (count <= 0 || !signature.any()) {
+        return;
+    }
+
+    Archetype* archetype = GetOrCreateArchetype(signature);
+    GetLocation(firstEntityId + count - 1);
+    for (int entityId = firstEntityId; entityId < firstEntityId + count; entityId++) {
+        EntityLocation& location = locations[entityId];
+        location.archetype = archetype;
+        archetype->AllocateRow(entityId, location.chunk, location.row);
+    }
+}
+
+void ArchetypeStorage::RemoveEntity(int entityId) {
+    if (entityId < static_cast<int>(locations.size()) && locations[entityId].archetype) {
+        MoveEntity(entityId, Signature());
+    }
+}
+
+void ArchetypeStorage::SetEnabled(int entityId, bool isEnabled) {
+    if (isEnabled) {
+        Remove<DisabledTag>(entityId);
+    } else {
+        Add<DisabledTag>(entityId);
+    }
+}
+
 Entity Registry::CreateEntity() {
     int entityId;
+    Entity entity;
 
-    if(freeIds.empty()) {
-        entityId = numEntities++;
-        if (entityId >= static_cast<int>(componentSignatures.size()))
-        {
-            componentSignatures.resize(entityId + 1);
+    if(freeListHead == NULL_ENTITY_INDEX) {
+        entityId = static_cast<int>(handles.size());
+        if (static_cast<uint32_t>(entityId) >= NULL_ENTITY_INDEX) {
+            Logger::Err("Out of entity indices.");
+            return Entity();
         }
+
+        entity = Entity(entityId, 0);
+        handles.push_back(entity);
+        componentSignatures.resize(entityId + 1);
+        isPendingKill.resize(entityId + 1, false);
+        isInSystems.resize(entityId + 1, false);
+        isDisabled.resize(entityId + 1, false);
+        tagPerEntity.resize(entityId + 1, -1);
+        groupPerEntity.resize(entityId + 1, -1);
+        groupIndexPerEntity.resize(entityId + 1, -1);
     } else {
-        entityId = freeIds.front();
-        freeIds.pop_front();
+        entityId = static_cast<int>(freeListHead);
+        const Entity freeSlot = handles[entityId];
+        freeListHead = static_cast<uint32_t>(freeSlot.GetId());
+
+        entity = Entity(entityId, freeSlot.GetGeneration());
+        handles[entityId] = entity;
     }
 
+    entitiesToBeAdded.push_back(entity);
+    entitiesCreated++;
 
-    Entity entity(entityId);
-    entity.registry = this;
-    entitiesToBeAdded.insert(entity);
+    return entity;
+}
 
-    Logger::Log("Entity " + std::to_string(entityId) + " created.");
+EntityRange Registry::CreateEntities(int count) {
+    // Bypass the free list so the block gets contiguous indices at the end of the handle table
+    const int first = static_cast<int>(handles.size());
+    if (count <= 0) {
+        return EntityRange(first, 0);
+    }
+    if (static_cast<uint32_t>(first) + static_cast<uint32_t>(count) > NULL_ENTITY_INDEX) {
+        Logger::Err("Out of entity indices.");
+        return EntityRange(first, 0);
+    }
 
+    const int size = first + count;
+    handles.reserve(size);
+    for (int entityId = first; entityId < size; entityId++) {
+        handles.push_back(Entity(entityId, 0));
+    }
+    componentSignatures.resize(size);
+    isPendingKill.resize(size, false);
+    isInSystems.resize(size, false);
+    isDisabled.resize(size, false);
+    tagPerEntity.resize(size, -1);
+    groupPerEntity.resize(size, -1);
+    groupIndexPerEntity.resize(size, -1);
+
+    entitiesToBeAdded.insert(entitiesToBeAdded.end(), handles.begin() + first, handles.end());
+    entitiesCreated += count;
+
+    Logger::Log("Entities " + std::to_string(first) + " to " + std::to_string(size - 1) + " created.");
+
+    return EntityRange(first, count);
+}
+
+void Prefab::Group(const std::string& group) {
+    groupId = Registry::GetGroupId(group);
+}
+
+void Registry::InstantiateComponents(const Prefab& prefab, int firstEntityId, int count) {
+    // Each entity gets its row in the final archetype once, rather than moving through one per component
+    if (archetypeStorage) {
+        for (const auto& component: prefab.components) {
+            component.registerComponent(*archetypeStorage);
+        }
+        archetypeStorage->AddEntities(firstEntityId, count, prefab.signature);
+    }
+
+    for (const auto& component: prefab.components) {
+        component.instantiate(*this, firstEntityId, count, component.value.get());
+    }
+
+    // New entities aren't in any system yet, so the signature can be written directly
+    for (int entityId = firstEntityId; entityId < firstEntityId + count; entityId++) {
+        componentSignatures[entityId] = prefab.signature;
+        if (prefab.groupId != -1) {
+            GroupEntity(handles[entityId], prefab.groupId);
+        }
+        prefab.signature.ForEach([&](int componentId) {
+            NotifyComponentAdded(handles[entityId], componentId);
+        });
+    }
+}
+
+Entity Registry::Instantiate(const Prefab& prefab) {
+    Entity entity = CreateEntity();
+    if (entity != Entity()) {
+        InstantiateComponents(prefab, entity.GetId(), 1);
+    }
     return entity;
 }
 
+EntityRange Registry::Instantiate(const Prefab& prefab, int count) {
+    EntityRange range = CreateEntities(count);
+    InstantiateComponents(prefab, range.GetFirstId(), range.GetSize());
+    return range;
+}
+
 void Registry::KillEntity(Entity entity) {
-    entitiesToBeKilled.insert(entity);
+    if (CommandBuffer* commandBuffer = CommandBuffer::GetActive()) {
+        commandBuffer->KillEntity(entity);
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(killMutex);
+    if (!IsAlive(entity) || isPendingKill[entity.GetId()]) {
+        return;
+    }
+    isPendingKill[entity.GetId()] = true;
+    entitiesToBeKilled.push_back(entity);
+}
+
+void Registry::MergeCommandBuffer(const CommandBuffer& commandBuffer) {
+    std::lock_guard<std::mutex> lock(killMutex);
+    for (auto entity: commandBuffer.GetEntitiesToBeKilled()) {
+        if (IsAlive(entity) && !isPendingKill[entity.GetId()]) {
+            isPendingKill[entity.GetId()] = true;
+            entitiesToBeKilled.push_back(entity);
+        }
+    }
 }
 
 void Registry::AddEntityToSystems(Entity entity) {
     const auto entityId = entity.GetId();
+    isInSystems[entityId] = true;
+
+    // (joins them when it's enabled again)
+    if (isDisabled[entityId]) {
+        return;
+    }
 
     const auto& entityComponentSignature = componentSignatures[entityId];
 
     for(auto& system: systems) {
-        const auto& systemComponentSignature = system.second->GetSignature();
-        bool isInterested = (entityComponentSignature & systemComponentSignature) == systemComponentSignature;
+        bool isInterested = system.second->Matches(entityComponentSignature);
 
         if(isInterested) {
             system.second->AddEntity(entity);
         }
     }
+
+    for (auto& query: queries) {
+        if (query.second->Matches(entityComponentSignature)) {
+            query.second->AddEntity(entity);
+        }
+    }
 }
 
 void Registry::RemoveEntityFromSystems(Entity entity) {
-    for(auto system: systems) {
+    for(auto& system: systems) {
         system.second->RemoveEntity(entity);
     }
+    for (auto& query: queries) {
+        query.second->RemoveEntity(entity);
+    }
+    isInSystems[entity.GetId()] = false;
+}
+
+void Registry::DisableEntity(Entity entity) {
+    const auto entityId = entity.GetId();
+    if (!IsAlive(entity) || isDisabled[entityId]) {
+        return;
+    }
+
+    // Leave the systems but stay marked as added, so enabling rejoins them
+    const bool wasInSystems = isInSystems[entityId];
+    RemoveEntityFromSystems(entity);
+    isInSystems[entityId] = wasInSystems;
+    isDisabled[entityId] = true;
+
+    if (archetypeStorage) {
+        archetypeStorage->SetEnabled(entityId, false);
+    }
+    componentSignatures[entityId].ForEach([&](int componentId) {
+        if (!archetypeStorage) {
+            componentPools[componentId]->SetEnabled(entityId, false);
+        }
+        // (views no longer visit the same set of entities)
+        componentChanges[componentId].structureVersion++;
+    });
+}
+
+void Registry::EnableEntity(Entity entity) {
+    const auto entityId = entity.GetId();
+    if (!IsAlive(entity) || !isDisabled[entityId]) {
+        return;
+    }
+
+    isDisabled[entityId] = false;
+
+    if (archetypeStorage) {
+        archetypeStorage->SetEnabled(entityId, true);
+    }
+    componentSignatures[entityId].ForEach([&](int componentId) {
+        if (!archetypeStorage) {
+            componentPools[componentId]->SetEnabled(entityId, true);
+        }
+        // (views no longer visit the same set of entities)
+        componentChanges[componentId].structureVersion++;
+    });
+
+    if (isInSystems[entityId]) {
+        AddEntityToSystems(entity);
+    }
+}
+
+void Registry::AddSystemToComponentLists(System* system) {
+    (system->GetSignature() | system->GetExcludedSignature()).ForEach([&](int componentId) {
+        if (componentId >= static_cast<int>(systemsPerComponent.size())) {
+            systemsPerComponent.resize(componentId + 1);
+        }
+        systemsPerComponent[componentId].push_back(system);
+    });
+}
+
+void Registry::RemoveSystemFromComponentLists(System* system) {
+    for (auto& componentSystems: systemsPerComponent) {
+        componentSystems.erase(std::remove(componentSystems.begin(), componentSystems.end(), system), componentSystems.end());
+    }
+}
+
+// Entities still waiting for Update() are matched against every system there, so only
+// entities that are already in the systems need their membership patched here.
+// Adding a component can also remove the entity from systems that exclude it, and vice versa.
+void Registry::OnComponentToggled(Entity entity, int componentId) {
+    const auto entityId = entity.GetId();
+    if (!isInSystems[entityId] || isDisabled[entityId] || componentId >= static_cast<int>(systemsPerComponent.size())) {
+        return;
+    }
+
+    const auto& entityComponentSignature = componentSignatures[entityId];
+    for (System* system: systemsPerComponent[componentId]) {
+        if (system->Matches(entityComponentSignature)) {
+            system->AddEntity(entity);
+        } else {
+            system->RemoveEntity(entity);
+        }
+    }
+}
+
+int Registry::GetTagId(const std::string& tag) {
+    return tagIds.emplace(tag, static_cast<int>(tagIds.size())).first->second;
+}
+
+int Registry::GetGroupId(const std::string& group) {
+    return groupIds.emplace(group, static_cast<int>(groupIds.size())).first->second;
 }
 
 void Registry::TagEntity(Entity entity, const std::string& tag) {
-    entityPerTag.emplace(tag, entity);
-    tagPerEntity.emplace(entity.GetId(), tag);
+    TagEntity(entity, GetTagId(tag));
+}
+
+void Registry::TagEntity(Entity entity, int tagId) {
+    RemoveEntityTag(entity);
+
+    if (tagId >= static_cast<int>(entityPerTag.size())) {
+        entityPerTag.resize(tagId + 1);
+    }
+    if (entityPerTag[tagId] != Entity()) {
+        tagPerEntity[entityPerTag[tagId].GetId()] = -1;
+    }
+
+    entityPerTag[tagId] = entity;
+    tagPerEntity[entity.GetId()] = tagId;
 }
 
 bool Registry::EntityHasTag(Entity entity, const std::string& tag) const {
-	if (tagPerEntity.find(entity.GetId()) == tagPerEntity.end()) {
-		return false;
-	}
-	return entityPerTag.find(tag)->second == entity;
+    auto tagId = tagIds.find(tag);
+	return tagId != tagIds.end() && EntityHasTag(entity, tagId->second);
 }
 
 Entity Registry::GetEntityByTag(const std::string& tag) const {
-    return entityPerTag.at(tag);
+    auto tagId = tagIds.find(tag);
+    if (tagId == tagIds.end() || tagId->second >= static_cast<int>(entityPerTag.size())) {
+        return Entity();
+    }
+    return entityPerTag[tagId->second];
 }
 
 void Registry::RemoveEntityTag(Entity entity) {
-	auto taggedEntity = tagPerEntity.find(entity.GetId());
-    if (taggedEntity != tagPerEntity.end()) {
-        auto tag = taggedEntity->second;
-        entityPerTag.erase(tag);
-        tagPerEntity.erase(taggedEntity);
+    const int tagId = tagPerEntity[entity.GetId()];
+    if (tagId != -1) {
+        entityPerTag[tagId] = Entity();
+        tagPerEntity[entity.GetId()] = -1;
     }
 }
 
 void Registry::GroupEntity(Entity entity, const std::string& group) {
-    entitiesPerGroup.emplace(group, std::set<Entity>());
-    entitiesPerGroup[group].emplace(entity);
-    groupPerEntity.emplace(entity.GetId(), group);
+    GroupEntity(entity, GetGroupId(group));
 }
 
-bool Registry::EntityBelongsToGroup(Entity entity, const std::string& group) const {
-    if(entitiesPerGroup.find(group) == entitiesPerGroup.end()) {
-        return false;
+void Registry::GroupEntity(Entity entity, int groupId) {
+    RemoveEntityGroup(entity);
+
+    if (groupId >= static_cast<int>(entitiesPerGroup.size())) {
+        entitiesPerGroup.resize(groupId + 1);
     }
-	auto groupEntities = entitiesPerGroup.at(group);
-    return groupEntities.find(entity.GetId()) != groupEntities.end();
+
+    groupPerEntity[entity.GetId()] = groupId;
+    groupIndexPerEntity[entity.GetId()] = static_cast<int>(entitiesPerGroup[groupId].size());
+    entitiesPerGroup[groupId].push_back(entity);
+}
+
+bool Registry::EntityBelongsToGroup(Entity entity, const std::string& group) const {
+    auto groupId = groupIds.find(group);
+    return groupId != groupIds.end() && EntityBelongsToGroup(entity, groupId->second);
 }
 
-std::vector<Entity> Registry::GetEntitiesByGroup(const std::string& group) const {
-    auto& setOfEntities = entitiesPerGroup.at(group);
-    return std::vector<Entity>(setOfEntities.begin(), setOfEntities.end());
+const std::vector<Entity>& Registry::GetEntitiesByGroup(const std::string& group) const {
+    auto groupId = groupIds.find(group);
+    return GetEntitiesByGroup(groupId != groupIds.end() ? groupId->second : -1);
+}
+
+const std::vector<Entity>& Registry::GetEntitiesByGroup(int groupId) const {
+    static const std::vector<Entity> noEntities;
+    if (groupId < 0 || groupId >= static_cast<int>(entitiesPerGroup.size())) {
+        return noEntities;
+    }
+    return entitiesPerGroup[groupId];
 }
 
 void Registry::RemoveEntityGroup(Entity entity) {
-    auto groupedEntity = groupPerEntity.find(entity.GetId());
-    if (groupedEntity != groupPerEntity.end()) {
-        auto group = entitiesPerGroup.find(groupedEntity->second);
-        if (group != entitiesPerGroup.end()) {
-            auto entityInGroup = group->second.find(entity);
-            if (entityInGroup != group->second.end()) {
-                group->second.erase(entityInGroup);
-            }
+    const int groupId = groupPerEntity[entity.GetId()];
+    if (groupId == -1) {
+        return;
+    }
+
+    // Swap-and-pop out of the group's packed list
+    auto& groupEntities = entitiesPerGroup[groupId];
+    const int indexOfRemoved = groupIndexPerEntity[entity.GetId()];
+    const Entity last = groupEntities.back();
+    groupEntities[indexOfRemoved] = last;
+    groupIndexPerEntity[last.GetId()] = indexOfRemoved;
+    groupEntities.pop_back();
+
+    groupPerEntity[entity.GetId()] = -1;
+    groupIndexPerEntity[entity.GetId()] = -1;
+}
+
+void Registry::Clear() {
+    for (int entityId = 0; entityId < static_cast<int>(handles.size()); entityId++) {
+        const Entity entity = handles[entityId];
+        // (free slots link to another index, live ones hold their own)
+        if (entity.GetId() != entityId) {
+            continue;
+        }
+
+        if (isInSystems[entityId]) {
+            RemoveEntityFromSystems(entity);
         }
-        groupPerEntity.erase(groupedEntity);
+        componentSignatures[entityId].reset();
+        isPendingKill[entityId] = false;
+        isDisabled[entityId] = false;
+        tagPerEntity[entityId] = -1;
+        groupPerEntity[entityId] = -1;
+        groupIndexPerEntity[entityId] = -1;
+
+        handles[entityId] = Entity(freeListHead, (entity.GetGeneration() + 1) & ENTITY_GENERATION_MASK);
+        freeListHead = static_cast<uint32_t>(entityId);
+        entitiesKilled++;
+    }
+
+    entitiesToBeAdded.clear();
+    entitiesToBeKilled.clear();
+    entityPerTag.clear();
+    entitiesPerGroup.clear();
+
+    componentPools.clear();
+    if (archetypeStorage) {
+        archetypeStorage = std::make_unique<ArchetypeStorage>();
+    }
+
+    for (auto& changes: componentChanges) {
+        changes.ticks.clear();
+        changes.version++;
+        changes.structureVersion++;
     }
+
+    Logger::Log("Entity registry cleared.");
+}
+
+void Registry::NotifyComponentAdded(Entity entity, int componentId) {
+    ComponentChanges& changes = componentChanges[componentId];
+    if (entity.GetId() >= static_cast<int>(changes.ticks.size())) {
+        changes.ticks.resize(handles.size(), 0);
+    }
+    changes.Stamp(entity.GetId(), GetChangeTick());
+    changes.version++;
+    changes.structureVersion++;
+
+    for (const auto& observer: changes.addedObservers) {
+        observer(entity);
+    }
+}
+
+void Registry::NotifyComponentRemoved(Entity entity, int componentId) {
+    ComponentChanges& changes = componentChanges[componentId];
+    for (const auto& observer: changes.removedObservers) {
+        observer(entity);
+    }
+
+    changes.version++;
+    changes.structureVersion++;
 }
 
 void Registry::Update() {
+    AdvanceChangeTick();
+
     for(auto entity: entitiesToBeAdded) {
         AddEntityToSystems(entity);
     }
 
     entitiesToBeAdded.clear();
 
-    for(auto entity: entitiesToBeKilled) {
+    // Removed-observers may kill more entities (e.g. children): those are applied in another round
+    while (!entitiesToBeKilled.empty()) {
+        entitiesBeingKilled.swap(entitiesToBeKilled);
+        ApplyKills();
+        entitiesBeingKilled.clear();
+    }
+}
+
+void Registry::ApplyKills() {
+    // Kills are applied in id order so the sparse arrays are walked front to back
+    std::sort(entitiesBeingKilled.begin(), entitiesBeingKilled.end(), [](const Entity& a, const Entity& b) {
+        return a.GetId() < b.GetId();
+    });
+
+    for(auto entity: entitiesBeingKilled) {
+        const auto entityId = entity.GetId();
         RemoveEntityFromSystems(entity);
-        componentSignatures[entity.GetId()].reset();
 
-        for(auto pool: componentPools) {
-            if(pool) {
-                pool->Remove(entity.GetId());
-            }
+        componentSignatures[entityId].ForEach([&](int componentId) {
+            NotifyComponentRemoved(entity, componentId);
+        });
+
+        // Only the pools in the entity's signature can hold one of its components
+        if (archetypeStorage) {
+            archetypeStorage->RemoveEntity(entityId);
+        } else {
+            componentSignatures[entityId].ForEach([&](int componentId) {
+                componentPools[componentId]->Remove(entityId);
+            });
         }
 
-        freeIds.push_back(entity.GetId());
+        componentSignatures[entityId].reset();
+        isPendingKill[entityId] = false;
+        isDisabled[entityId] = false;
+
+        // Bump the generation so outstanding handles to this entity stop resolving
+        handles[entityId] = Entity(freeListHead, (entity.GetGeneration() + 1) & ENTITY_GENERATION_MASK);
+        freeListHead = static_cast<uint32_t>(entityId);
+        entitiesKilled++;
         Logger::Log("Entity " + std::to_string(entity.GetId()) + " was killed.");
 
         RemoveEntityTag(entity);
 	    RemoveEntityGroup(entity);
     }
+}
 
-    entitiesToBeKilled.clear();
+RegistryStats Registry::GetStats() const {
+    RegistryStats stats;
+    stats.entitySlots = static_cast<int>(handles.size());
+    for (int entityId = 0; entityId < static_cast<int>(handles.size()); entityId++) {
+        if (handles[entityId].GetId() == entityId) {
+            stats.aliveEntities++;
+            stats.disabledEntities += isDisabled[entityId] ? 1 : 0;
+        }
+    }
+    stats.freeEntitySlots = stats.entitySlots - stats.aliveEntities;
+    stats.entitiesCreated = entitiesCreated;
+    stats.entitiesKilled = entitiesKilled;
+
+    stats.arenaPagesInUse = arena.GetPagesInUse();
+    stats.arenaFreePages = arena.GetFreePages();
+    // (vector<bool>s are counted at a bit per entry)
+    stats.entityBytes =
+        handles.capacity() * sizeof(Entity) +
+        componentSignatures.capacity() * sizeof(Signature) +
+        (tagPerEntity.capacity() + groupPerEntity.capacity() + groupIndexPerEntity.capacity()) * sizeof(int) +
+        (isPendingKill.capacity() + isInSystems.capacity() + isDisabled.capacity()) / 8;
+    for (const auto& changes: componentChanges) {
+        stats.changeTrackingBytes += changes.ticks.capacity() * sizeof(uint32_t);
+    }
+
+    for (int componentId = 0; componentId < static_cast<int>(componentPools.size()); componentId++) {
+        const IPool* pool = componentPools[componentId].get();
+        if (!pool) {
+            continue;
+        }
+        PoolStats poolStats;
+        poolStats.componentId = componentId;
+        poolStats.componentName = pool->GetComponentName();
+        poolStats.size = pool->GetSize();
+        poolStats.activeSize = pool->GetActiveSize();
+        poolStats.capacity = pool->GetCapacity();
+        poolStats.highWaterMark = pool->GetHighWaterMark();
+        poolStats.bytes = pool->GetBytes();
+        poolStats.sparseBytes = pool->GetSparseBytes();
+        stats.pools.push_back(poolStats);
+    }
+
+    if (archetypeStorage) {
+        for (const Archetype* archetype: archetypeStorage->GetArchetypes()) {
+            ArchetypeStats archetypeStats;
+            archetypeStats.signature = archetype->GetSignature();
+            archetypeStats.size = archetype->GetSize();
+            archetypeStats.chunkCount = archetype->GetChunkCount();
+            archetypeStats.chunkCapacity = archetype->GetChunkCapacity();
+            archetypeStats.bytes = archetype->GetChunkCount() * archetype->GetChunkBytes();
+            stats.archetypes.push_back(archetypeStats);
+        }
+    }
+
+    for (const auto& system: systems) {
+        stats.systems.push_back({system.first.name(), static_cast<int>(system.second->GetEntities().size())});
+    }
+    for (const auto& query: queries) {
+        stats.queries.push_back({query.first.name(), static_cast<int>(query.second->GetEntities().size())});
+    }
+
+    return stats;
+}
+
+size_t RegistryStats::GetTotalBytes() const {
+    size_t bytes = entityBytes + changeTrackingBytes;
+    for (const auto& pool: pools) {
+        bytes += pool.bytes + pool.sparseBytes;
+    }
+    for (const auto& archetype: archetypes) {
+        bytes += archetype.bytes;
+    }
+    return bytes;
+}
+
+std::string RegistryStats::ToString() const {
+    std::string dump = "Registry stats: " + std::to_string(aliveEntities) + " entities (" + std::to_string(disabledEntities) + " disabled) in " +
+        std::to_string(entitySlots) + " slots, " + std::to_string(entitiesCreated) + " created, " + std::to_string(entitiesKilled) + " killed, " +
+        std::to_string(GetTotalBytes() / 1024) + " KB";
+    dump += "\n  entities: " + std::to_string(entityBytes / 1024) + " KB, change tracking: " + std::to_string(changeTrackingBytes / 1024) + " KB" +
+        ", arena: " + std::to_string(arenaPagesInUse) + " pages in use, " + std::to_string(arenaFreePages) + " free";
+    for (const auto& pool: pools) {
+        dump += "\n  pool " + std::to_string(pool.componentId) + " " + pool.componentName + ": " +
+            std::to_string(pool.size) + "/" + std::to_string(pool.capacity) + " (" + std::to_string(pool.activeSize) + " enabled, peak " + std::to_string(pool.highWaterMark) + "), " +
+            std::to_string(pool.bytes / 1024) + " KB + " + std::to_string(pool.sparseBytes / 1024) + " KB sparse";
+    }
+    for (const auto& archetype: archetypes) {
+        dump += "\n  archetype " + archetype.signature.ToString() + ": " + std::to_string(archetype.size) + " entities in " +
+            std::to_string(archetype.chunkCount) + " chunks of " + std::to_string(archetype.chunkCapacity) + ", " + std::to_string(archetype.bytes / 1024) + " KB";
+    }
+    for (const auto& system: systems) {
+        dump += "\n  system " + system.name + ": " + std::to_string(system.entityCount) + " entities";
+    }
+    for (const auto& query: queries) {
+        dump += "\n  query " + query.name + ": " + std::to_string(query.entityCount) + " entities";
+    }
+    return dump;
 }
@@ -1,370 +1,1875 @@
-#pragma once
-
-#include <bitset>
-#include <vector>
-#include <set>
-#include <unordered_map>
-#include <typeindex>
-#include <memory>
-#include <deque>
-
-#include "../Logger/Logger.h"
-
-const unsigned int MAX_COMPONENTS = 32;
-
-// We use a bitset to keep track of which components an entity has,
-// and also helps keep track of which entities a system is interested in.
-typedef std::bitset<MAX_COMPONENTS> Signature;
-
-struct IComponent
-{
-protected:
-    static int nextId;
-};
-
-// Used to assign a unique id to a component type
-template <typename TComponent>
-class Component : public IComponent
-{
-    public:
-        // Returns the unique id of Component<T>
-        static int GetId()
-        {
-            static auto id = nextId++;
-            return id;
-        }
-};
-
-class Entity
-{
-private:
-    int id;
-
-public:
-    Entity(int id) : id(id) {}
-    Entity(const Entity& entity) = default;
-    void Kill();
-    int GetId() const;
-
-    void Tag(const std::string& tag);
-   	bool HasTag(const std::string& tag) const;
-   	void Group(const std::string& group);
-   	bool BelongsToGroup(const std::string& group) const;
-
-    template <typename TComponent, typename ...TArgs> void AddComponent(TArgs&& ...args);
-    template <typename TComponent> void RemoveComponent();
-    template <typename TComponent> bool HasComponent() const;
-    template <typename TComponent> TComponent& GetComponent() const;
-
-    Entity &operator=(const Entity &other) = default;
-    bool operator==(const Entity &other) const
-    {
-        return id == other.id;
-    }
-    bool operator!=(const Entity &other) const
-    {
-        return id != other.id;
-    }
-    bool operator>(const Entity &other) const
-    {
-        return id > other.id;
-    }
-    bool operator<(const Entity &other) const
-    {
-        return id < other.id;
-    }
-
-
-    class Registry* registry;
-};
-
-// The system processes entities that contain a specific signature
-class System
-{
-private:
-    Signature componentSignature;
-    std::vector<Entity> entities;
-
-public:
-    System() = default;
-    ~System() = default;
-
-    void AddEntity(Entity entity);
-    void RemoveEntity(Entity entity);
-    std::vector<Entity> GetEntities() const;
-    const Signature &GetSignature() const;
-
-    template <typename TComponent>
-    void RequireComponent();
-};
-
-// Used to hold a contiguous vector of objects of type T
-class IPool {
-    public:
-        virtual ~IPool() = default;
-        virtual void Remove(int entityId) = 0;
-};
-
-template <typename T>
-class Pool : public IPool {
-    private:
-        std::vector<T> data;
-        int size;
-
-        std::unordered_map<int, int> entityIdToIndex;
-        std::unordered_map<int, int> indexToEntityId;
-
-    public:
-        Pool(int capacity = 100) {
-           size = 0;
-           data.resize(capacity);
-        }
-
-        virtual ~Pool() = default;
-
-        bool IsEmpty() const {
-           return size == 0;
-        }
-
-        int GetSize() const {
-            return size;
-        }
-
-        void Resize(int size) {
-            data.resize(size);
-        }
-
-        void Clear() {
-            data.clear();
-            entityIdToIndex.clear();
-            indexToEntityId.clear();
-            size = 0;
-        }
-        void Add(T object) {
-            data.push_back(object);
-        }
-
-        void Set(int entityId, T object) {
-            if(entityIdToIndex.find(entityId) != entityIdToIndex.end()) {
-                int index = entityIdToIndex[entityId];
-                data[index] = object;
-            } else {
-                int index = size;
-                entityIdToIndex.emplace(entityId, index);
-                indexToEntityId.emplace(index, entityId);
-                if(index >= data.capacity()) {
-                    data.resize(size * 2);
-                }
-                data[index] = object;
-                size++;
-            }
-        }
-
-        void RemoveImpl(int entityId) {
-            int indexOfRemoved = entityIdToIndex[entityId];
-            int indexOfLast = size - 1;
-            data[indexOfRemoved] = data[indexOfLast];
-
-            int entityIdOfLastElement = indexToEntityId[indexOfLast];
-            entityIdToIndex[entityIdOfLastElement] = indexOfRemoved;
-            indexToEntityId[indexOfRemoved] = entityIdOfLastElement;
-
-            entityIdToIndex.erase(entityId);
-            indexToEntityId.erase(indexOfLast);
-
-            size--;
-        }
-
-        void Remove(int entityId) override {
-            if(entityIdToIndex.find(entityId) != entityIdToIndex.end()) {
-                RemoveImpl(entityId);
-            }
-        }
-
-        T& Get(int entityId) {
-            int index = entityIdToIndex[entityId];
-            return static_cast<T&>(data[index]);
-        }
-
-        T& operator [](unsigned int index) {
-            return data[index];
-        }
-};
-
-// The registry manages the creation and destruction of entities,
-// add systems and components.
-class Registry
-{
-    private:
-        int numEntities = 0;
-        std::vector<std::shared_ptr<IPool>> componentPools;
-        std::vector<Signature> componentSignatures;
-
-        std::unordered_map <std::type_index, std::shared_ptr<System>> systems;
-
-        std::set<Entity> entitiesToBeAdded;
-        std::set<Entity> entitiesToBeKilled;
-
-        // (one tag name per entity)
-       	std::unordered_map<std::string, Entity> entityPerTag;
-        std::unordered_map<int, std::string> tagPerEntity;
-
-        // (a set of entities per group name)
-        std::unordered_map<std::string, std::set<Entity>> entitiesPerGroup;
-        std::unordered_map<int, std::string> groupPerEntity;
-
-        std::deque<int> freeIds;
-    public:
-        Registry() {
-            Logger::Log("Entity registry created.");
-        }
-
-        ~Registry() {
-            Logger::Log("Entity registry destroyed.");
-        }
-
-        void Update();
-
-        Entity CreateEntity();
-        void KillEntity(Entity entity);
-
-        void TagEntity(Entity entity, const std::string& tag);
-		bool EntityHasTag(Entity entity, const std::string& tag) const;
-		Entity GetEntityByTag(const std::string& tag) const;
-		void RemoveEntityTag(Entity entity);
-
-		void GroupEntity(Entity entity, const std::string& group);
-		bool EntityBelongsToGroup(Entity entity, const std::string& group) const;
-		std::vector<Entity> GetEntitiesByGroup(const std::string& group) const;
-		void RemoveEntityGroup(Entity entity);
-
-        template <typename TComponent, typename ...TArgs> void AddComponent(
-            Entity entity,
-            TArgs&& ...args
-        );
-        template <typename TComponent> void RemoveComponent(Entity entity);
-        template <typename TComponent> bool HasComponent(Entity entity);
-        template <typename TComponent> TComponent& GetComponent(Entity entity) const;
-
-        template <typename TSystem, typename ...TArgs> void AddSystem(TArgs&& ...args);
-        template <typename TSystem> void RemoveSystem();
-        template <typename TSystem> bool HasSystem() const;
-        template <typename TSystem> TSystem& GetSystem() const;
-
-        void AddEntityToSystems(Entity entity);
-        void RemoveEntityFromSystems(Entity entity);
-};
-
-template <typename TComponent>
-void System::RequireComponent()
-{
-    const auto componentId = Component<TComponent>::GetId();
-    componentSignature.set(componentId);
-}
-
-template <typename TComponent, typename ...TArgs>
-void Registry::AddComponent(Entity entity, TArgs&& ...args) {
-    const auto componentId = Component<TComponent>::GetId();
-    const auto entityId = entity.GetId();
-
-    if (componentId >= static_cast<int>(componentPools.size()))
-    {
-        componentPools.resize(componentId + 1, nullptr);
-    }
-
-    if(!componentPools[componentId]) {
-        std::shared_ptr<Pool<TComponent>> newComponentPool = std::make_shared<Pool<TComponent>>();
-        componentPools[componentId] = newComponentPool;
-    }
-
-    std::shared_ptr<Pool<TComponent>> componentPool = std::static_pointer_cast<Pool<TComponent>>(componentPools[componentId]);
-
-    TComponent newComponent(std::forward<TArgs>(args)...);
-
-    componentPool->Set(entityId, newComponent);
-    componentSignatures[entityId].set(componentId);
-
-    Logger::Log("Component " + std::to_string(componentId) + " was added to entity " + std::to_string(entityId) + ".");
-}
-
-
-template <typename TComponent>
-void Registry::RemoveComponent(Entity entity) {
-    const auto componentId = Component<TComponent>::GetId();
-    const auto entityId = entity.GetId();
-
-    componentSignatures[entityId].set(componentId, false);
-
-    std::shared_ptr<Pool<TComponent>> componentPool = std::static_pointer_cast<Pool<TComponent>>(componentPools[componentId]);
-    componentPool->Remove(entityId);
-
-    Logger::Log("Component " + std::to_string(componentId) + " was removed from entity " + std::to_string(entityId) + ".");
-}
-
-template <typename TComponent>
-bool Registry::HasComponent(Entity entity) {
-    const auto componentId = Component<TComponent>::GetId();
-    const auto entityId = entity.GetId();
-
-    return componentSignatures[entityId].test(componentId);
-}
-
-template <typename TComponent>
-inline TComponent &Registry::GetComponent(Entity entity) const
-{
-    const auto componentId = Component<TComponent>::GetId();
-    const auto entityId = entity.GetId();
-
-    auto componentPool = std::static_pointer_cast<Pool<TComponent>>(componentPools[componentId]);
-    return componentPool->Get(entityId);
-}
-
-template <typename TSystem, typename ...TArgs>
-void Registry::AddSystem (TArgs&& ...args) {
-    std::shared_ptr<TSystem> newSystem = std::make_shared<TSystem>(std::forward<TArgs>(args)...);
-    systems.insert(std::make_pair(std::type_index(typeid(TSystem)), newSystem));
-}
-
-template <typename TSystem>
-void Registry::RemoveSystem () {
-    auto system = systems.find(std::type_index(typeid(TSystem)));
-    systems.erase(system);
-}
-
-
-template <typename TSystem>
-bool Registry::HasSystem() const {
-    auto system = systems.find(std::type_index(typeid(TSystem)));
-    return *(std::static_pointer_cast<TSystem>(system->second));
-}
-
-template <typename TSystem>
-inline TSystem &Registry::GetSystem() const
-{
-    auto system = systems.find(std::type_index(typeid(TSystem)));
-    return *(std::static_pointer_cast<TSystem>(system->second));
-}
-
-template <typename TComponent, typename... TArgs>
-inline void Entity::AddComponent(TArgs &&...args)
-{
-    registry->AddComponent<TComponent>(*this, std::forward<TArgs>(args)...);
-}
-
-template <typename TComponent>
-inline void Entity::RemoveComponent()
-{
-    registry->RemoveComponent<TComponent>(*this);
-}
-
-template <typename TComponent>
-inline bool Entity::HasComponent() const
-{
-    return registry->HasComponent<TComponent>(*this);
-}
-
-template <typename TComponent>
-inline TComponent &Entity::GetComponent() const
-{
-   return registry->GetComponent<TComponent>(*this);
-}
+#pragma once
+
+#include <vector>
+#include <unordered_map>
+#include <typeindex>
+#include <memory>
+#include <cstdint>
+#include <cstring>
+#include <new>
+#include <algorithm>
+#include <tuple>
+#include <type_traits>
+#include <functional>
+#include <mutex>
+#include <atomic>
+#include <array>
+#include <cassert>
+#include <cstdlib>
+
+#include "../Logger/Logger.h"
+#include "PageArena.h"
+#include "../Jobs/JobSystem.h"
+
+// Width of the signatures; build with -DECS_MAX_COMPONENTS=128 or 256 for more component types
+#ifndef ECS_MAX_COMPONENTS
+#define ECS_MAX_COMPONENTS 64
+#endif
+
+const unsigned int MAX_COMPONENTS = ECS_MAX_COMPONENTS;
+static_assert(MAX_COMPONENTS % 64 == 0 && MAX_COMPONENTS <= 256, "MAX_COMPONENTS must be 64, 128 or 256");
+
+// Ids below this are reserved for components that pin their id at compile time
+const unsigned int NUM_STATIC_COMPONENT_IDS = 32;
+
+// We use a bit set to keep track of which components an entity has,
+// and also helps keep track of which entities a system is interested in.
+// It is stored as plain 64-bit words so that matching a signature against a
+// system compiles down to a few wide AND/compare instructions.
+class Signature
+{
+private:
+    static const unsigned int NUM_WORDS = MAX_COMPONENTS / 64;
+    alignas(16) uint64_t words[NUM_WORDS] = {};
+
+public:
+    void set(size_t bit, bool value = true)
+    {
+        assert(bit < MAX_COMPONENTS);
+        const uint64_t mask = uint64_t(1) << (bit % 64);
+        words[bit / 64] = value ? (words[bit / 64] | mask) : (words[bit / 64] & ~mask);
+    }
+
+    void reset(size_t bit)
+    {
+        set(bit, false);
+    }
+
+    void reset()
+    {
+        for (unsigned int i = 0; i < NUM_WORDS; i++) {
+            words[i] = 0;
+        }
+    }
+
+    bool test(size_t bit) const
+    {
+        assert(bit < MAX_COMPONENTS);
+        return (words[bit / 64] >> (bit % 64)) & 1;
+    }
+
+    bool any() const
+    {
+        uint64_t bits = 0;
+        for (unsigned int i = 0; i < NUM_WORDS; i++) {
+            bits |= words[i];
+        }
+        return bits != 0;
+    }
+
+    bool none() const
+    {
+        return !any();
+    }
+
+    // True when every bit of the other signature is also set here
+    bool Contains(const Signature& other) const
+    {
+        uint64_t missing = 0;
+        for (unsigned int i = 0; i < NUM_WORDS; i++) {
+            missing |= other.words[i] & ~words[i];
+        }
+        return missing == 0;
+    }
+
+    // Calls func(componentId) for every set bit, in increasing order
+    template <typename TFunc>
+    void ForEach(TFunc func) const
+    {
+        for (unsigned int i = 0; i < NUM_WORDS; i++) {
+            uint64_t bits = words[i];
+            while (bits) {
+                func(static_cast<int>(i * 64 + __builtin_ctzll(bits)));
+                bits &= bits - 1;
+            }
+        }
+    }
+
+    // e.g. "{0 2 5}"
+    std::string ToString() const
+    {
+        std::string ids;
+        ForEach([&](int componentId) {
+            ids += (ids.empty() ? "" : " ") + std::to_string(componentId);
+        });
+        return "{" + ids + "}";
+    }
+
+    size_t Hash() const
+    {
+        size_t hash = 0;
+        for (unsigned int i = 0; i < NUM_WORDS; i++) {
+            hash ^= std::hash<uint64_t>()(words[i]) + 0x9e3779b97f4a7c15ull + (hash << 6) + (hash >> 2);
+        }
+        return hash;
+    }
+
+    Signature operator&(const Signature& other) const
+    {
+        Signature result;
+        for (unsigned int i = 0; i < NUM_WORDS; i++) {
+            result.words[i] = words[i] & other.words[i];
+        }
+        return result;
+    }
+
+    Signature operator|(const Signature& other) const
+    {
+        Signature result;
+        for (unsigned int i = 0; i < NUM_WORDS; i++) {
+            result.words[i] = words[i] | other.words[i];
+        }
+        return result;
+    }
+
+    bool operator==(const Signature& other) const
+    {
+        uint64_t difference = 0;
+        for (unsigned int i = 0; i < NUM_WORDS; i++) {
+            difference |= words[i] ^ other.words[i];
+        }
+        return difference == 0;
+    }
+
+    bool operator!=(const Signature& other) const
+    {
+        return !(*this == other);
+    }
+};
+
+namespace std {
+    template <>
+    struct hash<Signature> {
+        size_t operator()(const Signature& signature) const {
+            return signature.Hash();
+        }
+    };
+}
+
+struct IComponent
+{
+protected:
+    static int nextId;
+};
+
+template <typename TComponent, typename = void>
+struct HasStaticComponentId : std::false_type {};
+
+template <typename TComponent>
+struct HasStaticComponentId<TComponent, std::void_t<decltype(TComponent::StaticId)>> : std::true_type {};
+
+// Used to assign a unique id to a component type.
+// A component can pin its id at compile time by declaring `static constexpr int StaticId`;
+// those ids are stable across builds and runs. Every other component type is handed an
+// id at runtime, in first-use order, from the range above NUM_STATIC_COMPONENT_IDS.
+template <typename TComponent>
+class Component : public IComponent
+{
+    public:
+        // Returns the unique id of Component<T> (const T shares the id of T)
+        static int GetId()
+        {
+            if constexpr (std::is_const_v<TComponent>) {
+                return Component<std::remove_const_t<TComponent>>::GetId();
+            } else if constexpr (HasStaticComponentId<TComponent>::value) {
+                static_assert(TComponent::StaticId >= 0 && TComponent::StaticId < static_cast<int>(NUM_STATIC_COMPONENT_IDS), "Static component ids must be below NUM_STATIC_COMPONENT_IDS");
+                return TComponent::StaticId;
+            } else {
+                static auto id = NextDynamicId();
+                return id;
+            }
+        }
+
+    private:
+        static int NextDynamicId()
+        {
+            // (an id past the signature width would write out of bounds everywhere it's used)
+            if (nextId >= static_cast<int>(MAX_COMPONENTS)) {
+                Logger::Err("Too many component types, increase ECS_MAX_COMPONENTS.");
+                std::abort();
+            }
+            return nextId++;
+        }
+};
+
+// Entity handles pack an index and a generation into 32 bits. The index addresses
+// every per-entity array (pools, signatures, systems); the generation is bumped each
+// time the index is recycled, so a stale handle never aliases the entity that reuses it.
+const unsigned int ENTITY_INDEX_BITS = 20;
+const unsigned int ENTITY_GENERATION_BITS = 32 - ENTITY_INDEX_BITS;
+const uint32_t ENTITY_INDEX_MASK = (1u << ENTITY_INDEX_BITS) - 1;
+const uint32_t ENTITY_GENERATION_MASK = (1u << ENTITY_GENERATION_BITS) - 1;
+const uint32_t NULL_ENTITY_INDEX = ENTITY_INDEX_MASK;
+
+// Handles don't carry a registry pointer: they resolve against Registry::GetCurrent()
+class Entity
+{
+private:
+    uint32_t handle;
+
+public:
+    Entity() : handle(NULL_ENTITY_INDEX) {}
+    Entity(uint32_t index, uint32_t generation) : handle((generation << ENTITY_INDEX_BITS) | (index & ENTITY_INDEX_MASK)) {}
+    Entity(const Entity& entity) = default;
+    void Kill();
+    void Disable();
+    void Enable();
+    bool IsEnabled() const;
+    bool IsAlive() const;
+
+    // Index of the entity, used to address every per-entity array
+    int GetId() const {
+        return static_cast<int>(handle & ENTITY_INDEX_MASK);
+    }
+
+    uint32_t GetGeneration() const {
+        return handle >> ENTITY_INDEX_BITS;
+    }
+
+    uint32_t GetHandle() const {
+        return handle;
+    }
+
+    void Tag(const std::string& tag);
+   	bool HasTag(const std::string& tag) const;
+   	bool HasTag(int tagId) const;
+   	void Group(const std::string& group);
+   	bool BelongsToGroup(const std::string& group) const;
+   	bool BelongsToGroup(int groupId) const;
+
+    template <typename TComponent, typename ...TArgs> void AddComponent(TArgs&& ...args);
+    template <typename TComponent> void RemoveComponent();
+    template <typename TComponent> bool HasComponent() const;
+    template <typename TComponent> TComponent& GetComponent() const;
+    // Flags a write made through GetComponent for change tracking
+    template <typename TComponent> void MarkChanged() const;
+
+    Entity &operator=(const Entity &other) = default;
+    bool operator==(const Entity &other) const
+    {
+        return handle == other.handle;
+    }
+    bool operator!=(const Entity &other) const
+    {
+        return handle != other.handle;
+    }
+    bool operator>(const Entity &other) const
+    {
+        return handle > other.handle;
+    }
+    bool operator<(const Entity &other) const
+    {
+        return handle < other.handle;
+    }
+};
+
+static_assert(sizeof(Entity) == 4, "Entity handles are meant to stay 32 bits");
+
+// A block of entities created together by Registry::CreateEntities, with contiguous fresh indices
+class EntityRange
+{
+private:
+    int first = 0;
+    int count = 0;
+
+public:
+    EntityRange() = default;
+    EntityRange(int first, int count) : first(first), count(count) {}
+
+    int GetFirstId() const {
+        return first;
+    }
+
+    int GetSize() const {
+        return count;
+    }
+
+    bool IsEmpty() const {
+        return count == 0;
+    }
+
+    // Fresh indices always start at generation 0
+    Entity operator [](int index) const {
+        return Entity(first + index, 0);
+    }
+};
+
+// The system processes entities that contain a specific signature
+class System
+{
+private:
+    Signature componentSignature;
+    std::vector<Entity> entities;
+
+    // Position of each entity id in the entities vector, -1 when it isn't part of the system
+    std::vector<int> entityIndices;
+
+    // Components an entity must not have to be part of the system
+    Signature excludedSignature;
+
+    // Component access declared for the system scheduler (required components count as reads)
+    Signature readSignature;
+    Signature writeSignature;
+    bool isExclusive = false;
+
+public:
+    System() = default;
+    virtual ~System() = default;
+
+    void AddEntity(Entity entity);
+    void RemoveEntity(Entity entity);
+    bool HasEntity(Entity entity) const;
+    const std::vector<Entity>& GetEntities() const;
+    const Signature &GetSignature() const;
+
+    template <typename TComponent>
+    void RequireComponent();
+    template <typename TComponent>
+    void ExcludeComponent();
+
+    const Signature& GetExcludedSignature() const {
+        return excludedSignature;
+    }
+
+    // Whether an entity with this component signature belongs to the system
+    bool Matches(const Signature& signature) const {
+        return signature.Contains(componentSignature) && (signature & excludedSignature).none();
+    }
+
+    template <typename TComponent>
+    void ReadsComponent();
+    template <typename TComponent>
+    void WritesComponent();
+
+    // For systems that create entities, add or remove components, emit events or
+    // otherwise touch shared state: they run with no other system alongside them
+    void RequireExclusiveAccess() {
+        isExclusive = true;
+    }
+
+    Signature GetReadSignature() const {
+        return readSignature | componentSignature;
+    }
+    const Signature& GetWriteSignature() const {
+        return writeSignature;
+    }
+    bool IsExclusive() const {
+        return isExclusive;
+    }
+};
+
+const unsigned int SPARSE_PAGE_SIZE = 4096;
+
+// Base of every component pool. It owns the sparse set that maps entity ids
+// to positions in the packed arrays: a paged, direct-indexed sparse array
+// (entity id -> packed index) plus a dense array of entity ids (packed index -> entity id).
+// The packed arrays keep the enabled entities first and the disabled ones after them,
+// so iterating the first GetActiveSize() entries never visits a disabled entity.
+class IPool {
+    private:
+        std::vector<std::unique_ptr<int[]>> sparsePages;
+
+    protected:
+        std::vector<int> dense;
+        int activeSize = 0;
+        int highWaterMark = 0;
+
+        // Swaps which components two packed indices refer to
+        virtual void SwapSlots(int a, int b) = 0;
+
+        void SwapEntries(int a, int b) {
+            if (a == b) {
+                return;
+            }
+            SwapSlots(a, b);
+            std::swap(dense[a], dense[b]);
+            SetIndex(dense[a], a);
+            SetIndex(dense[b], b);
+        }
+
+        // Moves a just appended entry (enabled) in front of the disabled ones
+        void ActivateLast() {
+            SwapEntries(GetSize() - 1, activeSize);
+            activeSize++;
+            highWaterMark = std::max(highWaterMark, GetSize());
+        }
+
+        // Moves the entry at index to the end of the enabled ones and returns its new index
+        int DeactivateAt(int index) {
+            SwapEntries(index, activeSize - 1);
+            activeSize--;
+            return activeSize;
+        }
+
+        void SetIndex(int entityId, int index) {
+            const size_t page = entityId / SPARSE_PAGE_SIZE;
+            if (page >= sparsePages.size()) {
+                sparsePages.resize(page + 1);
+            }
+            if (!sparsePages[page]) {
+                sparsePages[page] = std::make_unique<int[]>(SPARSE_PAGE_SIZE);
+                std::fill_n(sparsePages[page].get(), SPARSE_PAGE_SIZE, -1);
+            }
+            sparsePages[page][entityId % SPARSE_PAGE_SIZE] = index;
+        }
+
+        void ClearIndices() {
+            sparsePages.clear();
+            dense.clear();
+            activeSize = 0;
+        }
+
+    public:
+        virtual ~IPool() = default;
+        virtual void Remove(int entityId) = 0;
+
+        // Returns the packed index of the entity, or -1 if it isn't in the pool
+        int IndexOf(int entityId) const {
+            const size_t page = entityId / SPARSE_PAGE_SIZE;
+            if (page >= sparsePages.size() || !sparsePages[page]) {
+                return -1;
+            }
+            return sparsePages[page][entityId % SPARSE_PAGE_SIZE];
+        }
+
+        bool Contains(int entityId) const {
+            return IndexOf(entityId) != -1;
+        }
+
+        int GetSize() const {
+            return static_cast<int>(dense.size());
+        }
+
+        bool IsEmpty() const {
+            return dense.empty();
+        }
+
+        // Number of enabled entities, which are the first ones of GetEntityIds()
+        int GetActiveSize() const {
+            return activeSize;
+        }
+
+        // Moves the entity across the enabled/disabled boundary: O(1), one swap at most
+        void SetEnabled(int entityId, bool isEnabled) {
+            const int index = IndexOf(entityId);
+            if (index == -1 || (index < activeSize) == isEnabled) {
+                return;
+            }
+            if (isEnabled) {
+                SwapEntries(index, activeSize);
+                activeSize++;
+            } else {
+                DeactivateAt(index);
+            }
+        }
+
+        // Entity ids in packed order
+        const std::vector<int>& GetEntityIds() const {
+            return dense;
+        }
+
+        // Memory and occupancy, see Registry::GetStats
+        int GetHighWaterMark() const {
+            return highWaterMark;
+        }
+        size_t GetSparseBytes() const {
+            size_t bytes = sparsePages.capacity() * sizeof(sparsePages[0]);
+            for (const auto& page: sparsePages) {
+                bytes += page ? SPARSE_PAGE_SIZE * sizeof(int) : 0;
+            }
+            return bytes;
+        }
+        virtual int GetCapacity() const = 0;
+        virtual size_t GetBytes() const = 0;
+        virtual const char* GetComponentName() const = 0;
+};
+
+constexpr int FloorLog2(size_t value) {
+    return value <= 1 ? 0 : 1 + FloorLog2(value / 2);
+}
+
+// Used to hold the objects of type T in slots of fixed-size arena pages. The dense entity array stays
+// packed for iteration and maps each packed index to a slot; removing a component or toggling an entity
+// only reorders those indices, and freed slots are reused. Slots are constructed only when a component
+// is added and pages never move, so a component keeps its address until it's removed.
+// Empty types (tag components) have nothing to store: their pool is just the membership set, and
+// every slot is one shared instance.
+template <typename T>
+class Pool : public IPool {
+    private:
+        static_assert(sizeof(T) <= ARENA_PAGE_SIZE, "Components must fit in an arena page");
+        static_assert(alignof(T) <= ARENA_PAGE_ALIGNMENT, "Components can't be aligned beyond an arena page");
+
+        static constexpr bool IS_TAG = std::is_empty_v<T>;
+        static inline T tag{};
+
+        // Objects per page, rounded down to a power of two so slot lookups are a shift and a mask
+        static constexpr int PAGE_SHIFT = FloorLog2(ARENA_PAGE_SIZE / sizeof(T));
+        static constexpr int PAGE_MASK = (1 << PAGE_SHIFT) - 1;
+
+        PageArena& arena;
+        std::vector<T*> pages;
+
+        // Slot of the component at each packed index (parallel to dense), and the slots free for reuse
+        std::vector<int> slotOfIndex;
+        std::vector<int> freeSlots;
+        int slotCount = 0;
+
+        T* Slot(int slot) const {
+            if constexpr (IS_TAG) {
+                return &tag;
+            }
+            return pages[slot >> PAGE_SHIFT] + (slot & PAGE_MASK);
+        }
+
+        T* At(int index) const {
+            if constexpr (IS_TAG) {
+                return &tag;
+            }
+            return Slot(slotOfIndex[index]);
+        }
+
+        int AllocateSlot() {
+            if (!freeSlots.empty()) {
+                const int slot = freeSlots.back();
+                freeSlots.pop_back();
+                return slot;
+            }
+            ReservePages(slotCount + 1);
+            return slotCount++;
+        }
+
+        void ReservePages(int capacity) {
+            if constexpr (IS_TAG) {
+                return;
+            }
+            while ((static_cast<int>(pages.size()) << PAGE_SHIFT) < capacity) {
+                pages.push_back(static_cast<T*>(arena.AllocatePage()));
+            }
+        }
+
+    public:
+        Pool(PageArena& arena): arena(arena) {}
+
+        virtual ~Pool() {
+            Clear();
+        }
+
+        void Reserve(int capacity) {
+            ReservePages(capacity);
+            dense.reserve(capacity);
+            if constexpr (!IS_TAG) {
+                slotOfIndex.reserve(capacity);
+            }
+        }
+
+        // Destroys every object and hands the pages back to the arena
+        void Clear() {
+            if constexpr (!IS_TAG) {
+                for (int index = 0; index < GetSize(); index++) {
+                    At(index)->~T();
+                }
+            }
+            for (T* page: pages) {
+                arena.FreePage(page);
+            }
+            pages.clear();
+            slotOfIndex.clear();
+            freeSlots.clear();
+            slotCount = 0;
+            ClearIndices();
+        }
+
+        void Set(int entityId, T object) {
+            const int index = IndexOf(entityId);
+            if (index != -1) {
+                if constexpr (!IS_TAG) {
+                    *At(index) = std::move(object);
+                }
+            } else {
+                if constexpr (!IS_TAG) {
+                    const int slot = AllocateSlot();
+                    new (Slot(slot)) T(std::move(object));
+                    slotOfIndex.push_back(slot);
+                }
+                SetIndex(entityId, GetSize());
+                dense.push_back(entityId);
+                ActivateLast();
+            }
+        }
+
+        // Appends copies of one object for a block of entity ids that aren't in the pool yet.
+        // Trivially copyable types are copied bytewise.
+        void Fill(int firstEntityId, int count, const T& object) {
+            ReservePages(slotCount + count);
+            for (int i = 0; i < count; i++) {
+                if constexpr (!IS_TAG) {
+                    const int slot = AllocateSlot();
+                    if constexpr (std::is_trivially_copyable<T>::value) {
+                        std::memcpy(static_cast<void*>(Slot(slot)), &object, sizeof(T));
+                    } else {
+                        new (Slot(slot)) T(object);
+                    }
+                    slotOfIndex.push_back(slot);
+                }
+                SetIndex(firstEntityId + i, GetSize());
+                dense.push_back(firstEntityId + i);
+                ActivateLast();
+            }
+        }
+
+        // The component is destroyed in place and its slot freed; no other component moves
+        void Remove(int entityId) override {
+            int indexOfRemoved = IndexOf(entityId);
+            if (indexOfRemoved == -1) {
+                return;
+            }
+            if (indexOfRemoved < activeSize) {
+                indexOfRemoved = DeactivateAt(indexOfRemoved);
+            }
+
+            if constexpr (!IS_TAG) {
+                const int slot = slotOfIndex[indexOfRemoved];
+                Slot(slot)->~T();
+                freeSlots.push_back(slot);
+            }
+
+            const int indexOfLast = GetSize() - 1;
+            if (indexOfRemoved != indexOfLast) {
+                if constexpr (!IS_TAG) {
+                    slotOfIndex[indexOfRemoved] = slotOfIndex[indexOfLast];
+                }
+                dense[indexOfRemoved] = dense[indexOfLast];
+                SetIndex(dense[indexOfRemoved], indexOfRemoved);
+            }
+
+            if constexpr (!IS_TAG) {
+                slotOfIndex.pop_back();
+            }
+            dense.pop_back();
+            SetIndex(entityId, -1);
+        }
+
+        int GetCapacity() const override {
+            return IS_TAG ? 0 : static_cast<int>(pages.size()) << PAGE_SHIFT;
+        }
+
+        // Component pages plus the packed entity ids and slot indices
+        size_t GetBytes() const override {
+            return pages.size() * ARENA_PAGE_SIZE + (dense.capacity() + slotOfIndex.capacity() + freeSlots.capacity()) * sizeof(int);
+        }
+
+        const char* GetComponentName() const override {
+            return typeid(T).name();
+        }
+
+        void SwapSlots(int a, int b) override {
+            if constexpr (!IS_TAG) {
+                std::swap(slotOfIndex[a], slotOfIndex[b]);
+            }
+        }
+
+        T& Get(int entityId) {
+            if constexpr (IS_TAG) {
+                return tag;
+            }
+            const int index = IndexOf(entityId);
+            assert(index != -1 && "Pool::Get on an entity without the component");
+            return *At(index);
+        }
+
+        // Access by packed index, in the same order as GetEntityIds()
+        T& operator [](unsigned int index) {
+            return *At(index);
+        }
+};
+
+// Where the registry keeps component data. Both modes sit behind the same
+// AddComponent/GetComponent/View API so they can be benchmarked against each other.
+enum class StorageMode {
+    SparseSet,
+    Archetype
+};
+
+const size_t ARCHETYPE_CHUNK_SIZE = 16 * 1024;
+const size_t ARCHETYPE_CHUNK_ALIGNMENT = 64;
+
+// Type-erased operations needed to move components between archetype chunks
+struct ComponentInfo {
+    size_t size = 0;
+    size_t alignment = 0;
+    void (*moveConstruct)(void* destination, void* source) = nullptr;
+    void (*destroy)(void* component) = nullptr;
+};
+
+// Fixed-size block of memory holding entities of a single archetype.
+// The layout is SoA: the entity ids come first, then one contiguous column per component type.
+struct ArchetypeChunk {
+    unsigned char* memory = nullptr;
+    int count = 0;
+};
+
+// All the entities that share the same signature live together in the chunks of one archetype
+class Archetype {
+    private:
+        Signature signature;
+        std::vector<int> columnOfComponent;
+        std::vector<ComponentInfo> columnInfos;
+        std::vector<size_t> columnOffsets;
+        int chunkCapacity;
+        std::vector<ArchetypeChunk> chunks;
+
+        void* GetSlot(int chunk, int row, int column) const {
+            return chunks[chunk].memory + columnOffsets[column] + row * columnInfos[column].size;
+        }
+
+    public:
+        Archetype(const Signature& signature, const std::vector<ComponentInfo>& componentInfos);
+        ~Archetype();
+        Archetype(const Archetype&) = delete;
+        Archetype& operator=(const Archetype&) = delete;
+
+        const Signature& GetSignature() const {
+            return signature;
+        }
+
+        int GetColumnCount() const {
+            return static_cast<int>(columnInfos.size());
+        }
+
+        // Returns the column that stores the component, or -1 if the archetype doesn't have it
+        int GetColumn(int componentId) const {
+            return columnOfComponent[componentId];
+        }
+
+        int GetChunkCount() const {
+            return static_cast<int>(chunks.size());
+        }
+
+        int GetChunkSize(int chunk) const {
+            return chunks[chunk].count;
+        }
+
+        int GetChunkCapacity() const {
+            return chunkCapacity;
+        }
+
+        size_t GetChunkBytes() const {
+            return std::max(ARCHETYPE_CHUNK_SIZE, columnOffsets.empty() ? sizeof(int) : columnOffsets.back() + columnInfos.back().size * chunkCapacity);
+        }
+
+        int GetSize() const;
+
+        const int* GetEntityIds(int chunk) const {
+            return reinterpret_cast<const int*>(chunks[chunk].memory);
+        }
+
+        void* GetColumnData(int chunk, int column) const {
+            return chunks[chunk].memory + columnOffsets[column];
+        }
+
+        void* GetComponent(int chunk, int row, int column) const {
+            return GetSlot(chunk, row, column);
+        }
+
+        // Reserves a row at the end of the archetype; its components are left unconstructed
+        void AllocateRow(int entityId, int& chunk, int& row);
+
+        // Removes a row and fills the hole with the last row of the archetype.
+        // Returns the id of the entity that was moved into the hole, or -1.
+        int RemoveRow(int chunk, int row);
+};
+
+// Internal tag that moves disabled entities to archetypes of their own, which iteration skips
+struct DisabledTag {};
+
+// Archetype-based component storage: every entity is a row in the archetype matching its signature.
+// Adding or removing a component moves the entity's row to another archetype.
+class ArchetypeStorage {
+    private:
+        struct EntityLocation {
+            Archetype* archetype = nullptr;
+            int chunk = 0;
+            int row = 0;
+        };
+
+        std::vector<ComponentInfo> componentInfos;
+        std::unordered_map<Signature, std::unique_ptr<Archetype>> archetypesBySignature;
+        std::vector<Archetype*> archetypes;
+        std::vector<EntityLocation> locations;
+
+        Archetype* GetOrCreateArchetype(const Signature& signature);
+        EntityLocation& GetLocation(int entityId);
+        void MoveEntity(int entityId, const Signature& newSignature);
+
+    public:
+        ArchetypeStorage() = default;
+        ~ArchetypeStorage() = default;
+
+        template <typename TComponent> void RegisterComponent();
+        template <typename TComponent, typename ...TArgs> void Add(int entityId, TArgs&& ...args);
+        template <typename TComponent> void Remove(int entityId);
+        template <typename TComponent> TComponent& Get(int entityId);
+        void RemoveEntity(int entityId);
+        void SetEnabled(int entityId, bool isEnabled);
+
+        // Bulk creation: new entities go straight to the archetype of their final signature, and then
+        // each of their components is constructed in place (all of the signature's must be registered)
+        void AddEntities(int firstEntityId, int count, const Signature& signature);
+        template <typename TComponent> void Construct(int entityId, const TComponent& component);
+
+        const std::vector<Archetype*>& GetArchetypes() const {
+            return archetypes;
+        }
+
+        template <typename ...TComponents> int Count() const;
+        template <typename ...TComponents, typename TFunc> void Each(const std::vector<Entity>& handles, TFunc func) const;
+
+        // The chunks holding entities with all of the components, and iteration over one of them
+        template <typename ...TComponents> std::vector<std::pair<const Archetype*, int>> GetChunks() const;
+        template <typename ...TComponents, typename TFunc> static void EachInChunk(const std::vector<Entity>& handles, const Archetype* archetype, int chunk, TFunc func);
+};
+
+template <typename TComponent>
+void ArchetypeStorage::RegisterComponent() {
+    const auto componentId = Component<TComponent>::GetId();
+    if (componentId >= static_cast<int>(componentInfos.size())) {
+        componentInfos.resize(componentId + 1);
+    }
+    if (componentInfos[componentId].moveConstruct) {
+        return;
+    }
+
+    ComponentInfo& info = componentInfos[componentId];
+    // Empty (tag) components take no room: all the rows share one address
+    info.size = std::is_empty_v<TComponent> ? 0 : sizeof(TComponent);
+    info.alignment = alignof(TComponent);
+    info.moveConstruct = [](void* destination, void* source) {
+        new (destination) TComponent(std::move(*static_cast<TComponent*>(source)));
+    };
+    info.destroy = [](void* component) {
+        static_cast<TComponent*>(component)->~TComponent();
+    };
+}
+
+template <typename TComponent, typename ...TArgs>
+void ArchetypeStorage::Add(int entityId, TArgs&& ...args) {
+    RegisterComponent<TComponent>();
+    const auto componentId = Component<TComponent>::GetId();
+
+    EntityLocation& location = GetLocation(entityId);
+    if (location.archetype && location.archetype->GetColumn(componentId) != -1) {
+        Get<TComponent>(entityId) = TComponent(std::forward<TArgs>(args)...);
+        return;
+    }
+
+    Signature newSignature = location.archetype ? location.archetype->GetSignature() : Signature();
+    newSignature.set(componentId);
+    MoveEntity(entityId, newSignature);
+
+    EntityLocation& newLocation = GetLocation(entityId);
+    void* slot = newLocation.archetype->GetComponent(newLocation.chunk, newLocation.row, newLocation.archetype->GetColumn(componentId));
+    new (slot) TComponent(std::forward<TArgs>(args)...);
+}
+
+template <typename TComponent>
+void ArchetypeStorage::Construct(int entityId, const TComponent& component) {
+    EntityLocation& location = GetLocation(entityId);
+    void* slot = location.archetype->GetComponent(location.chunk, location.row, location.archetype->GetColumn(Component<TComponent>::GetId()));
+    new (slot) TComponent(component);
+}
+
+template <typename TComponent>
+void ArchetypeStorage::Remove(int entityId) {
+    const auto componentId = Component<TComponent>::GetId();
+
+    EntityLocation& location = GetLocation(entityId);
+    if (!location.archetype || location.archetype->GetColumn(componentId) == -1) {
+        return;
+    }
+
+    Signature newSignature = location.archetype->GetSignature();
+    newSignature.reset(componentId);
+    MoveEntity(entityId, newSignature);
+}
+
+template <typename TComponent>
+TComponent& ArchetypeStorage::Get(int entityId) {
+    const EntityLocation& location = locations[entityId];
+    const int column = location.archetype->GetColumn(Component<TComponent>::GetId());
+    return *static_cast<TComponent*>(location.archetype->GetComponent(location.chunk, location.row, column));
+}
+
+template <typename ...TComponents>
+int ArchetypeStorage::Count() const {
+    Signature required;
+    (required.set(Component<TComponents>::GetId()), ...);
+
+    int count = 0;
+    for (const Archetype* archetype: archetypes) {
+        if (archetype->GetSignature().Contains(required) && !archetype->GetSignature().test(Component<DisabledTag>::GetId())) {
+            count += archetype->GetSize();
+        }
+    }
+    return count;
+}
+
+template <typename ...TComponents, typename TFunc>
+void ArchetypeStorage::Each(const std::vector<Entity>& handles, TFunc func) const {
+    Signature required;
+    (required.set(Component<TComponents>::GetId()), ...);
+
+    // Indexed loops: callbacks may create archetypes or chunks while we iterate
+    for (size_t a = 0; a < archetypes.size(); a++) {
+        const Archetype* archetype = archetypes[a];
+        if (!archetype->GetSignature().Contains(required) || archetype->GetSignature().test(Component<DisabledTag>::GetId())) {
+            continue;
+        }
+
+        for (int chunk = 0; chunk < archetype->GetChunkCount(); chunk++) {
+            EachInChunk<TComponents...>(handles, archetype, chunk, func);
+        }
+    }
+}
+
+template <typename ...TComponents>
+std::vector<std::pair<const Archetype*, int>> ArchetypeStorage::GetChunks() const {
+    Signature required;
+    (required.set(Component<TComponents>::GetId()), ...);
+
+    std::vector<std::pair<const Archetype*, int>> chunks;
+    for (const Archetype* archetype: archetypes) {
+        if (archetype->GetSignature().Contains(required) && !archetype->GetSignature().test(Component<DisabledTag>::GetId())) {
+            for (int chunk = 0; chunk < archetype->GetChunkCount(); chunk++) {
+                chunks.emplace_back(archetype, chunk);
+            }
+        }
+    }
+    return chunks;
+}
+
+template <typename ...TComponents, typename TFunc>
+void ArchetypeStorage::EachInChunk(const std::vector<Entity>& handles, const Archetype* archetype, int chunk, TFunc func) {
+    const int* entityIds = archetype->GetEntityIds(chunk);
+    const std::tuple<TComponents*...> columns(
+        static_cast<TComponents*>(archetype->GetColumnData(chunk, archetype->GetColumn(Component<TComponents>::GetId())))...
+    );
+    for (int row = 0; row < archetype->GetChunkSize(chunk); row++) {
+        func(handles[entityIds[row]], std::get<TComponents*>(columns)[std::is_empty_v<TComponents> ? 0 : row]...);
+    }
+}
+
+const int DEFAULT_PARALLEL_CHUNK_SIZE = 256;
+
+// Structural changes made from inside a parallel loop. Every chunk of the loop records into its own
+// buffer (the one active on the thread running it), and the buffers are merged into the registry
+// in chunk order once the loop is done; the changes are then applied by the next Registry::Update.
+class CommandBuffer {
+    private:
+        std::vector<Entity> entitiesToBeKilled;
+
+        static thread_local CommandBuffer* active;
+
+    public:
+        void KillEntity(Entity entity) {
+            entitiesToBeKilled.push_back(entity);
+        }
+
+        const std::vector<Entity>& GetEntitiesToBeKilled() const {
+            return entitiesToBeKilled;
+        }
+
+        static CommandBuffer* GetActive() {
+            return active;
+        }
+
+        // Returns the buffer that was active before, to restore it afterwards
+        static CommandBuffer* SetActive(CommandBuffer* commandBuffer) {
+            CommandBuffer* previous = active;
+            active = commandBuffer;
+            return previous;
+        }
+};
+
+// Change tracking for one component type. ticks[entityId] is the change tick at which the entity's
+// component was last added or written; version bumps on every change to any entity's component and
+// structureVersion only when the set of (enabled) entities that own the component changes.
+struct ComponentChanges {
+    std::vector<uint32_t> ticks;
+    uint32_t version = 0;
+    uint32_t structureVersion = 0;
+    std::vector<std::function<void(Entity)>> addedObservers;
+    std::vector<std::function<void(Entity)>> removedObservers;
+
+    void Stamp(int entityId, uint32_t tick) {
+        if (entityId >= static_cast<int>(ticks.size())) {
+            ticks.resize(entityId + 1, 0);
+        }
+        ticks[entityId] = tick;
+    }
+};
+
+// Iterates every entity that has all of the requested components.
+// With sparse-set storage it walks the packed arrays of the smallest pool and looks
+// the others up through their sparse arrays; with archetype storage it sweeps the
+// columns of every matching archetype. Either way nothing is copied or allocated.
+// Components requested as const are read-only; the others are stamped as changed for every
+// entity visited, so ask for const access wherever the loop doesn't write.
+template <typename ...TComponents>
+class ComponentView {
+    private:
+        static constexpr bool HAS_WRITES = (!std::is_const_v<TComponents> || ...);
+
+        const std::vector<Entity>* handles;
+        const ArchetypeStorage* archetypeStorage;
+        std::tuple<Pool<std::remove_const_t<TComponents>>*...> pools;
+
+        // Change tracking of the writable components (null for the const ones)
+        std::array<ComponentChanges*, sizeof...(TComponents)> changes;
+        uint32_t changeTick;
+
+        void BumpVersions() const {
+            for (ComponentChanges* componentChanges: changes) {
+                if (componentChanges) {
+                    componentChanges->version++;
+                }
+            }
+        }
+
+        void Stamp(int entityId) const {
+            for (ComponentChanges* componentChanges: changes) {
+                if (componentChanges) {
+                    componentChanges->Stamp(entityId, changeTick);
+                }
+            }
+        }
+
+        // Wraps func so every entity it's called for gets its writable components stamped
+        template <typename TFunc>
+        auto StampingFunc(TFunc& func) const {
+            return [this, &func](Entity entity, TComponents& ...components) {
+                Stamp(entity.GetId());
+                func(entity, components...);
+            };
+        }
+
+        IPool* GetSmallestPool() const {
+            IPool* smallest = nullptr;
+            std::apply([&smallest](auto* ...pool) {
+                ((smallest = (!smallest || pool->GetActiveSize() < smallest->GetActiveSize()) ? pool : smallest), ...);
+            }, pools);
+            return smallest;
+        }
+
+    public:
+        ComponentView(
+            const std::vector<Entity>* handles,
+            const ArchetypeStorage* archetypeStorage,
+            const std::array<ComponentChanges*, sizeof...(TComponents)>& changes,
+            uint32_t changeTick,
+            Pool<std::remove_const_t<TComponents>>* ...pools
+        ):
+            handles(handles), archetypeStorage(archetypeStorage), pools(pools...), changes(changes), changeTick(changeTick) {}
+
+        bool IsEmpty() const {
+            if (archetypeStorage) {
+                return archetypeStorage->Count<TComponents...>() == 0;
+            }
+            return std::apply([](auto* ...pool) { return ((!pool || pool->GetActiveSize() == 0) || ...); }, pools);
+        }
+
+        // Upper bound of the number of entities the view will visit
+        int SizeHint() const {
+            if (archetypeStorage) {
+                return archetypeStorage->Count<TComponents...>();
+            }
+            return IsEmpty() ? 0 : GetSmallestPool()->GetActiveSize();
+        }
+
+        // Calls func(Entity, TComponents&...) for every matching entity
+        template <typename TFunc>
+        void Each(TFunc func) const {
+            if (IsEmpty()) {
+                return;
+            }
+
+            if constexpr (HAS_WRITES) {
+                BumpVersions();
+            }
+
+            if (archetypeStorage) {
+                if constexpr (HAS_WRITES) {
+                    archetypeStorage->Each<TComponents...>(*handles, StampingFunc(func));
+                } else {
+                    archetypeStorage->Each<TComponents...>(*handles, func);
+                }
+                return;
+            }
+
+            const IPool* leadPool = GetSmallestPool();
+            const auto& entityIds = leadPool->GetEntityIds();
+
+            // Indexed loop: pools may grow while we iterate (e.g. spawning projectiles)
+            for (int i = 0; i < leadPool->GetActiveSize(); i++) {
+                const int entityId = entityIds[i];
+                const bool hasAll = std::apply([entityId](auto* ...pool) { return (pool->Contains(entityId) && ...); }, pools);
+                if (!hasAll) {
+                    continue;
+                }
+                if constexpr (HAS_WRITES) {
+                    Stamp(entityId);
+                }
+                func((*handles)[entityId], std::get<Pool<std::remove_const_t<TComponents>>*>(pools)->Get(entityId)...);
+            }
+        }
+
+        // Like Each, but the entities are split in chunks of chunkSize that run as jobs; returns once all are done.
+        // func must only touch the components it's given (and other data nothing else writes meanwhile).
+        // Entities killed from func go through per-chunk command buffers.
+        template <typename TFunc>
+        void ParallelEach(JobSystem& jobSystem, int chunkSize, TFunc func) const;
+};
+
+// The registry manages the creation and destruction of entities,
+// add systems and components.
+class Registry;
+
+// A pre-built bundle of components (and group) that Registry::Instantiate stamps onto new entities
+class Prefab
+{
+    private:
+        struct PrefabComponent {
+            int componentId;
+            std::shared_ptr<void> value;
+            void (*instantiate)(Registry& registry, int firstEntityId, int count, const void* value);
+            void (*registerComponent)(ArchetypeStorage& archetypeStorage);
+        };
+
+        Signature signature;
+        std::vector<PrefabComponent> components;
+        int groupId = -1;
+
+        friend class Registry;
+
+    public:
+        Prefab() = default;
+
+        template <typename TComponent, typename ...TArgs> void AddComponent(TArgs&& ...args);
+        void Group(const std::string& group);
+
+        const Signature& GetSignature() const {
+            return signature;
+        }
+};
+
+// Snapshot of a registry's memory use and occupancy, see Registry::GetStats
+struct PoolStats {
+    int componentId = 0;
+    std::string componentName;
+    int size = 0;
+    int activeSize = 0;
+    int capacity = 0;
+    int highWaterMark = 0;
+    size_t bytes = 0;
+    size_t sparseBytes = 0;
+};
+
+struct ArchetypeStats {
+    Signature signature;
+    int size = 0;
+    int chunkCount = 0;
+    int chunkCapacity = 0;
+    size_t bytes = 0;
+};
+
+struct SystemStats {
+    std::string name;
+    int entityCount = 0;
+};
+
+struct RegistryStats {
+    int aliveEntities = 0;
+    int disabledEntities = 0;
+    // Slots of the handle table (the highest entity index so far + 1), and how many are free
+    int entitySlots = 0;
+    int freeEntitySlots = 0;
+    // Entity churn since the registry was created
+    uint64_t entitiesCreated = 0;
+    uint64_t entitiesKilled = 0;
+
+    size_t arenaPagesInUse = 0;
+    size_t arenaFreePages = 0;
+    // Handle table, signatures and the rest of the per-entity state
+    size_t entityBytes = 0;
+    size_t changeTrackingBytes = 0;
+
+    std::vector<PoolStats> pools;
+    std::vector<ArchetypeStats> archetypes;
+    std::vector<SystemStats> systems;
+    std::vector<SystemStats> queries;
+
+    size_t GetTotalBytes() const;
+    std::string ToString() const;
+};
+
+class Registry
+{
+    private:
+        static Registry* current;
+
+        StorageMode storageMode;
+
+        // Handle table, one slot per entity index. Live slots hold the entity's current handle.
+        // Free slots form an intrusive free list: their index bits link to the next free slot
+        // and their generation is the one the index will be handed out with next.
+        std::vector<Entity> handles;
+        uint32_t freeListHead = NULL_ENTITY_INDEX;
+
+        // Backs the component pools; declared first so it outlives them
+        PageArena arena;
+
+        std::vector<std::shared_ptr<IPool>> componentPools;
+        std::unique_ptr<ArchetypeStorage> archetypeStorage;
+        std::vector<Signature> componentSignatures;
+
+        std::unordered_map <std::type_index, std::shared_ptr<System>> systems;
+
+        // Cached query results, kept up to date exactly like system entity sets
+        std::unordered_map<std::type_index, std::unique_ptr<System>> queries;
+
+        // Systems (and queries) that require or exclude each component id, so a component toggle only re-tests those
+        std::vector<std::vector<System*>> systemsPerComponent;
+
+        // Structural changes recorded during the frame, applied in one pass by Update()
+        std::vector<Entity> entitiesToBeAdded;
+        std::vector<Entity> entitiesToBeKilled;
+        // The kills Update() is applying, swapped out so removed-observers can kill more entities
+        std::vector<Entity> entitiesBeingKilled;
+        std::vector<bool> isPendingKill;
+
+        // Systems running in parallel may kill entities at the same time
+        std::mutex killMutex;
+
+        // Whether the entity has gone through AddEntityToSystems and has its membership kept up to date
+        std::vector<bool> isInSystems;
+
+        // Disabled entities keep their components but are left out of systems, queries and views
+        std::vector<bool> isDisabled;
+
+        uint64_t entitiesCreated = 0;
+        uint64_t entitiesKilled = 0;
+
+        // Change tracking per component id, allocated up front so views never resize it
+        std::vector<ComponentChanges> componentChanges = std::vector<ComponentChanges>(MAX_COMPONENTS);
+        std::atomic<uint32_t> changeTick{1};
+
+        void NotifyComponentAdded(Entity entity, int componentId);
+        void NotifyComponentRemoved(Entity entity, int componentId);
+        void ApplyKills();
+
+        void AddSystemToComponentLists(System* system);
+        void RemoveSystemFromComponentLists(System* system);
+        void OnComponentToggled(Entity entity, int componentId);
+
+        template <typename TComponent> Pool<TComponent>* GetOrCreatePool();
+        template <typename TComponent> static void InstantiateComponent(Registry& registry, int firstEntityId, int count, const void* value);
+        void InstantiateComponents(const Prefab& prefab, int firstEntityId, int count);
+
+        friend class Prefab;
+
+        // Tag and group names are interned to small ids, shared by every registry
+        static std::unordered_map<std::string, int> tagIds;
+        static std::unordered_map<std::string, int> groupIds;
+
+        // (one tag per entity and one entity per tag, indexed by entity index / tag id)
+        std::vector<int> tagPerEntity;
+        std::vector<Entity> entityPerTag;
+
+        // (one group per entity, and a packed list of entities per group id)
+        std::vector<int> groupPerEntity;
+        std::vector<int> groupIndexPerEntity;
+        std::vector<std::vector<Entity>> entitiesPerGroup;
+
+    public:
+        Registry(StorageMode storageMode = StorageMode::SparseSet): storageMode(storageMode) {
+            if (storageMode == StorageMode::Archetype) {
+                archetypeStorage = std::make_unique<ArchetypeStorage>();
+            }
+            current = this;
+            Logger::Log(std::string("Entity registry created (") + (storageMode == StorageMode::Archetype ? "archetype" : "sparse set") + " storage).");
+        }
+
+        ~Registry() {
+            if (current == this) {
+                current = nullptr;
+            }
+            Logger::Log("Entity registry destroyed.");
+        }
+
+        // The registry entity handles resolve against (the most recently created one by default)
+        static Registry* GetCurrent() {
+            return current;
+        }
+        static void SetCurrent(Registry* registry) {
+            current = registry;
+        }
+
+        void Update();
+
+        // Destroys every entity and component at once (e.g. on level unload). Pool pages go back
+        // to the arena and are reused by the next level unless ReleaseMemory() frees them.
+        void Clear();
+        void ReleaseMemory() {
+            arena.Release();
+        }
+        const PageArena& GetArena() const {
+            return arena;
+        }
+
+        // Memory use and occupancy of the entities, pools, archetypes and systems. Walks every
+        // entity slot, so it's meant for periodic reports rather than every frame.
+        RegistryStats GetStats() const;
+
+        StorageMode GetStorageMode() const {
+            return storageMode;
+        }
+        const ArchetypeStorage* GetArchetypeStorage() const {
+            return archetypeStorage.get();
+        }
+
+        Entity CreateEntity();
+        EntityRange CreateEntities(int count);
+
+        // Create entities carrying a copy of the prefab's components; callers override per-instance fields after
+        Entity Instantiate(const Prefab& prefab);
+        EntityRange Instantiate(const Prefab& prefab, int count);
+        void KillEntity(Entity entity);
+
+        // Puts the entity to sleep without touching its components, or wakes it up. Both are O(1)
+        // per component and, like adding components, are structural changes.
+        void DisableEntity(Entity entity);
+        void EnableEntity(Entity entity);
+        bool IsEntityEnabled(Entity entity) const {
+            return !isDisabled[entity.GetId()];
+        }
+
+        bool IsAlive(Entity entity) const {
+            const auto index = entity.GetId();
+            return index < static_cast<int>(handles.size()) && handles[index] == entity;
+        }
+
+        // Interns the name; hot paths look the id up once and compare ids afterwards
+        static int GetTagId(const std::string& tag);
+        static int GetGroupId(const std::string& group);
+
+        void TagEntity(Entity entity, const std::string& tag);
+        void TagEntity(Entity entity, int tagId);
+		bool EntityHasTag(Entity entity, const std::string& tag) const;
+		bool EntityHasTag(Entity entity, int tagId) const {
+            return tagPerEntity[entity.GetId()] == tagId;
+        }
+		// -1 when the entity has no tag
+		int GetEntityTagId(Entity entity) const {
+            return tagPerEntity[entity.GetId()];
+        }
+		Entity GetEntityByTag(const std::string& tag) const;
+		void RemoveEntityTag(Entity entity);
+
+		void GroupEntity(Entity entity, const std::string& group);
+		void GroupEntity(Entity entity, int groupId);
+		bool EntityBelongsToGroup(Entity entity, const std::string& group) const;
+		bool EntityBelongsToGroup(Entity entity, int groupId) const {
+            return groupPerEntity[entity.GetId()] == groupId;
+        }
+		// -1 when the entity isn't in a group
+		int GetEntityGroupId(Entity entity) const {
+            return groupPerEntity[entity.GetId()];
+        }
+		const std::vector<Entity>& GetEntitiesByGroup(const std::string& group) const;
+		const std::vector<Entity>& GetEntitiesByGroup(int groupId) const;
+		void RemoveEntityGroup(Entity entity);
+
+        template <typename TComponent, typename ...TArgs> void AddComponent(
+            Entity entity,
+            TArgs&& ...args
+        );
+        // Adds one component to every entity of the range, init(i) builds the component for range[i]
+        template <typename TComponent, typename TInit> void AddComponents(
+            const EntityRange& range,
+            TInit init
+        );
+        template <typename TComponent> void RemoveComponent(Entity entity);
+        template <typename TComponent> bool HasComponent(Entity entity);
+        // (for empty tag components HasComponent is all there is to ask: they all share one instance)
+        // With sparse set storage the reference stays valid until that component is removed; archetype
+        // storage moves an entity's components whenever its signature changes or it's disabled.
+        template <typename TComponent> TComponent& GetComponent(Entity entity) const;
+        template <typename TComponent> TComponent* TryGetComponent(Entity entity) const;
+        template <typename TComponent> Pool<TComponent>* GetPool() const;
+        template <typename ...TComponents> ComponentView<TComponents...> View();
+
+        // Change tracking. Adding a component, or visiting it through a view that asked for
+        // non-const access, stamps it with the current change tick and bumps the component's
+        // version. Writes through GetComponent aren't seen: follow them with MarkChanged.
+        uint32_t GetChangeTick() const {
+            return changeTick.load(std::memory_order_relaxed);
+        }
+        // Starts a new tick and returns it; HasChanged(entity, tick) later tells what changed since
+        uint32_t AdvanceChangeTick() {
+            return changeTick.fetch_add(1, std::memory_order_relaxed) + 1;
+        }
+        template <typename TComponent> uint32_t GetComponentVersion() const;
+        template <typename TComponent> uint32_t GetComponentStructureVersion() const;
+        template <typename TComponent> void MarkChanged(Entity entity);
+        template <typename TComponent> bool HasChanged(Entity entity, uint32_t sinceTick) const;
+
+        // Observers run on the thread making the change: right after the component is added, and
+        // right before it's removed (killed entities included). Clear() doesn't notify.
+        template <typename TComponent> void OnComponentAdded(std::function<void(Entity)> observer);
+        template <typename TComponent> void OnComponentRemoved(std::function<void(Entity)> observer);
+
+        // Returns the cached query, created and filled on first use. Creating one is a structural
+        // change: do it from the main thread, not from systems running in parallel.
+        template <typename TQuery> TQuery& GetQuery();
+
+        template <typename TSystem, typename ...TArgs> void AddSystem(TArgs&& ...args);
+        template <typename TSystem> void RemoveSystem();
+        template <typename TSystem> bool HasSystem() const;
+        template <typename TSystem> TSystem& GetSystem() const;
+
+        void AddEntityToSystems(Entity entity);
+        void RemoveEntityFromSystems(Entity entity);
+
+        // Queues the buffer's kills as if KillEntity had been called for each of them
+        void MergeCommandBuffer(const CommandBuffer& commandBuffer);
+};
+
+template <typename ...TComponents> struct With {};
+template <typename ...TComponents> struct Without {};
+template <typename ...TComponents> struct Optional {};
+template <typename ...TComponents> struct Changed {};
+
+// Cached set of the entities that have every With<> component and none of the Without<> ones,
+// obtained through Registry::GetQuery. Each() hands the With<> components by reference and the
+// Optional<> ones as pointers that are null when the entity lacks them.
+// With Changed<> components (which are required too), Each() only visits the entities where at
+// least one of them was added or changed since the previous Each().
+template <typename TWith, typename TWithout = Without<>, typename TOptional = Optional<>, typename TChanged = Changed<>>
+class Query;
+
+template <typename ...TWith, typename ...TWithout, typename ...TOptional, typename ...TChanged>
+class Query<With<TWith...>, Without<TWithout...>, Optional<TOptional...>, Changed<TChanged...>> : public System {
+    private:
+        Registry* registry;
+        uint32_t lastChangeTick = 0;
+
+    public:
+        Query(Registry* registry): registry(registry) {
+            (RequireComponent<TWith>(), ...);
+            (RequireComponent<TChanged>(), ...);
+            (ExcludeComponent<TWithout>(), ...);
+        }
+
+        template <typename TFunc>
+        void Each(TFunc func) {
+            if constexpr (sizeof...(TChanged) > 0) {
+                const uint32_t sinceTick = lastChangeTick;
+                lastChangeTick = registry->AdvanceChangeTick();
+                for (auto entity: GetEntities()) {
+                    if ((registry->HasChanged<TChanged>(entity, sinceTick) || ...)) {
+                        func(entity, registry->GetComponent<TWith>(entity)..., registry->TryGetComponent<TOptional>(entity)...);
+                    }
+                }
+            } else {
+                for (auto entity: GetEntities()) {
+                    func(entity, registry->GetComponent<TWith>(entity)..., registry->TryGetComponent<TOptional>(entity)...);
+                }
+            }
+        }
+};
+
+template <typename TComponent>
+void System::RequireComponent()
+{
+    const auto componentId = Component<TComponent>::GetId();
+    componentSignature.set(componentId);
+}
+
+template <typename ...TComponents>
+template <typename TFunc>
+void ComponentView<TComponents...>::ParallelEach(JobSystem& jobSystem, int chunkSize, TFunc func) const {
+    if (IsEmpty()) {
+        return;
+    }
+
+    if constexpr (HAS_WRITES) {
+        BumpVersions();
+    }
+
+    std::vector<CommandBuffer> commandBuffers;
+
+    if (archetypeStorage) {
+        // Archetype chunks are the natural unit of work
+        const auto chunks = archetypeStorage->GetChunks<TComponents...>();
+        commandBuffers.resize(chunks.size());
+        jobSystem.ParallelFor(static_cast<int>(chunks.size()), 1, [&](int begin, int end) {
+            for (int i = begin; i < end; i++) {
+                CommandBuffer* previous = CommandBuffer::SetActive(&commandBuffers[i]);
+                if constexpr (HAS_WRITES) {
+                    ArchetypeStorage::EachInChunk<TComponents...>(*handles, chunks[i].first, chunks[i].second, StampingFunc(func));
+                } else {
+                    ArchetypeStorage::EachInChunk<TComponents...>(*handles, chunks[i].first, chunks[i].second, func);
+                }
+                CommandBuffer::SetActive(previous);
+            }
+        });
+    } else {
+        const std::vector<int>& entityIds = GetSmallestPool()->GetEntityIds();
+        const int activeSize = GetSmallestPool()->GetActiveSize();
+        chunkSize = std::max(1, chunkSize);
+        commandBuffers.resize((activeSize + chunkSize - 1) / chunkSize);
+        jobSystem.ParallelFor(activeSize, chunkSize, [&](int begin, int end) {
+            CommandBuffer* previous = CommandBuffer::SetActive(&commandBuffers[begin / chunkSize]);
+            for (int i = begin; i < end; i++) {
+                const int entityId = entityIds[i];
+                const bool hasAll = std::apply([entityId](auto* ...pool) { return (pool->Contains(entityId) && ...); }, pools);
+                if (hasAll) {
+                    if constexpr (HAS_WRITES) {
+                        Stamp(entityId);
+                    }
+                    func((*handles)[entityId], std::get<Pool<std::remove_const_t<TComponents>>*>(pools)->Get(entityId)...);
+                }
+            }
+            CommandBuffer::SetActive(previous);
+        });
+    }
+
+    // Merge through the registry's (locked) kill queue: whole systems may run in parallel too
+    for (const auto& commandBuffer: commandBuffers) {
+        if (!commandBuffer.GetEntitiesToBeKilled().empty()) {
+            Registry::GetCurrent()->MergeCommandBuffer(commandBuffer);
+        }
+    }
+}
+
+template <typename TComponent>
+void System::ExcludeComponent()
+{
+    excludedSignature.set(Component<TComponent>::GetId());
+}
+
+template <typename TComponent>
+void System::ReadsComponent()
+{
+    readSignature.set(Component<TComponent>::GetId());
+}
+
+template <typename TComponent>
+void System::WritesComponent()
+{
+    writeSignature.set(Component<TComponent>::GetId());
+}
+
+template <typename TComponent, typename ...TArgs>
+void Registry::AddComponent(Entity entity, TArgs&& ...args) {
+    const auto componentId = Component<TComponent>::GetId();
+    const auto entityId = entity.GetId();
+
+    if (archetypeStorage) {
+        archetypeStorage->Add<TComponent>(entityId, std::forward<TArgs>(args)...);
+        componentSignatures[entityId].set(componentId);
+        OnComponentToggled(entity, componentId);
+        NotifyComponentAdded(entity, componentId);
+        return;
+    }
+
+    Pool<TComponent>* componentPool = GetOrCreatePool<TComponent>();
+    componentPool->Set(entityId, TComponent(std::forward<TArgs>(args)...));
+    if (isDisabled[entityId]) {
+        componentPool->SetEnabled(entityId, false);
+    }
+    componentSignatures[entityId].set(componentId);
+    OnComponentToggled(entity, componentId);
+    NotifyComponentAdded(entity, componentId);
+}
+
+template <typename TComponent, typename TInit>
+void Registry::AddComponents(const EntityRange& range, TInit init) {
+    const auto componentId = Component<TComponent>::GetId();
+
+    if (archetypeStorage) {
+        for (int i = 0; i < range.GetSize(); i++) {
+            const Entity entity = range[i];
+            archetypeStorage->Add<TComponent>(entity.GetId(), init(i));
+            componentSignatures[entity.GetId()].set(componentId);
+            OnComponentToggled(entity, componentId);
+            NotifyComponentAdded(entity, componentId);
+        }
+    } else {
+        Pool<TComponent>* componentPool = GetOrCreatePool<TComponent>();
+        componentPool->Reserve(componentPool->GetSize() + range.GetSize());
+
+        for (int i = 0; i < range.GetSize(); i++) {
+            const Entity entity = range[i];
+            componentPool->Set(entity.GetId(), init(i));
+            if (isDisabled[entity.GetId()]) {
+                componentPool->SetEnabled(entity.GetId(), false);
+            }
+            componentSignatures[entity.GetId()].set(componentId);
+            OnComponentToggled(entity, componentId);
+            NotifyComponentAdded(entity, componentId);
+        }
+    }
+
+    Logger::Log("Component " + std::to_string(componentId) + " was added to " + std::to_string(range.GetSize()) + " entities.");
+}
+
+template <typename TComponent>
+void Registry::RemoveComponent(Entity entity) {
+    const auto componentId = Component<TComponent>::GetId();
+    const auto entityId = entity.GetId();
+
+    // Nothing to remove: observers and versions only see real removals
+    if (!componentSignatures[entityId].test(componentId)) {
+        return;
+    }
+
+    NotifyComponentRemoved(entity, componentId);
+    componentSignatures[entityId].set(componentId, false);
+    OnComponentToggled(entity, componentId);
+
+    if (archetypeStorage) {
+        archetypeStorage->Remove<TComponent>(entityId);
+    } else {
+        static_cast<Pool<TComponent>*>(componentPools[componentId].get())->Remove(entityId);
+    }
+
+    Logger::Log("Component " + std::to_string(componentId) + " was removed from entity " + std::to_string(entityId) + ".");
+}
+
+template <typename TComponent>
+bool Registry::HasComponent(Entity entity) {
+    const auto componentId = Component<TComponent>::GetId();
+    const auto entityId = entity.GetId();
+
+    return componentSignatures[entityId].test(componentId);
+}
+
+template <typename TComponent>
+inline TComponent &Registry::GetComponent(Entity entity) const
+{
+    const auto componentId = Component<TComponent>::GetId();
+    const auto entityId = entity.GetId();
+    assert(componentSignatures[entityId].test(componentId) && "GetComponent on an entity without the component");
+
+    if (archetypeStorage) {
+        return archetypeStorage->Get<TComponent>(entityId);
+    }
+    assert(componentId < static_cast<int>(componentPools.size()) && componentPools[componentId] && "GetComponent for a component type without a pool");
+
+    return static_cast<Pool<TComponent>*>(componentPools[componentId].get())->Get(entityId);
+}
+
+template <typename TComponent>
+TComponent* Registry::TryGetComponent(Entity entity) const {
+    if (!componentSignatures[entity.GetId()].test(Component<TComponent>::GetId())) {
+        return nullptr;
+    }
+    return &GetComponent<TComponent>(entity);
+}
+
+template <typename TComponent>
+Pool<TComponent>* Registry::GetPool() const {
+    const auto componentId = Component<TComponent>::GetId();
+    if (componentId >= static_cast<int>(componentPools.size())) {
+        return nullptr;
+    }
+    return static_cast<Pool<TComponent>*>(componentPools[componentId].get());
+}
+
+template <typename TComponent>
+Pool<TComponent>* Registry::GetOrCreatePool() {
+    const auto componentId = Component<TComponent>::GetId();
+    if (componentId >= static_cast<int>(componentPools.size())) {
+        componentPools.resize(componentId + 1, nullptr);
+    }
+    if (!componentPools[componentId]) {
+        componentPools[componentId] = std::make_shared<Pool<TComponent>>(arena);
+    }
+    return static_cast<Pool<TComponent>*>(componentPools[componentId].get());
+}
+
+template <typename TComponent>
+void Registry::InstantiateComponent(Registry& registry, int firstEntityId, int count, const void* value) {
+    const TComponent& component = *static_cast<const TComponent*>(value);
+
+    if (registry.archetypeStorage) {
+        for (int entityId = firstEntityId; entityId < firstEntityId + count; entityId++) {
+            registry.archetypeStorage->Construct<TComponent>(entityId, component);
+        }
+        return;
+    }
+
+    registry.GetOrCreatePool<TComponent>()->Fill(firstEntityId, count, component);
+}
+
+template <typename TComponent, typename ...TArgs>
+void Prefab::AddComponent(TArgs&& ...args) {
+    const auto componentId = Component<TComponent>::GetId();
+    std::shared_ptr<void> value = std::make_shared<TComponent>(std::forward<TArgs>(args)...);
+
+    for (auto& component: components) {
+        if (component.componentId == componentId) {
+            component.value = value;
+            return;
+        }
+    }
+
+    signature.set(componentId);
+    components.push_back({
+        componentId,
+        value,
+        &Registry::InstantiateComponent<TComponent>,
+        [](ArchetypeStorage& archetypeStorage) { archetypeStorage.RegisterComponent<TComponent>(); }
+    });
+}
+
+template <typename ...TComponents>
+ComponentView<TComponents...> Registry::View() {
+    return ComponentView<TComponents...>(
+        &handles,
+        archetypeStorage.get(),
+        {(std::is_const_v<TComponents> ? nullptr : &componentChanges[Component<TComponents>::GetId()])...},
+        GetChangeTick(),
+        GetPool<std::remove_const_t<TComponents>>()...
+    );
+}
+
+template <typename TComponent>
+uint32_t Registry::GetComponentVersion() const {
+    return componentChanges[Component<TComponent>::GetId()].version;
+}
+
+template <typename TComponent>
+uint32_t Registry::GetComponentStructureVersion() const {
+    return componentChanges[Component<TComponent>::GetId()].structureVersion;
+}
+
+template <typename TComponent>
+void Registry::MarkChanged(Entity entity) {
+    ComponentChanges& changes = componentChanges[Component<TComponent>::GetId()];
+    changes.Stamp(entity.GetId(), GetChangeTick());
+    changes.version++;
+}
+
+template <typename TComponent>
+bool Registry::HasChanged(Entity entity, uint32_t sinceTick) const {
+    const auto componentId = Component<TComponent>::GetId();
+    const auto entityId = entity.GetId();
+    const std::vector<uint32_t>& ticks = componentChanges[componentId].ticks;
+    return componentSignatures[entityId].test(componentId) && entityId < static_cast<int>(ticks.size()) && ticks[entityId] >= sinceTick;
+}
+
+template <typename TComponent>
+void Registry::OnComponentAdded(std::function<void(Entity)> observer) {
+    componentChanges[Component<TComponent>::GetId()].addedObservers.push_back(std::move(observer));
+}
+
+template <typename TComponent>
+void Registry::OnComponentRemoved(std::function<void(Entity)> observer) {
+    componentChanges[Component<TComponent>::GetId()].removedObservers.push_back(std::move(observer));
+}
+
+template <typename TQuery>
+TQuery& Registry::GetQuery() {
+    auto query = queries.find(std::type_index(typeid(TQuery)));
+    if (query == queries.end()) {
+        auto newQuery = std::make_unique<TQuery>(this);
+        for (int entityId = 0; entityId < static_cast<int>(handles.size()); entityId++) {
+            if (isInSystems[entityId] && !isDisabled[entityId] && newQuery->Matches(componentSignatures[entityId])) {
+                newQuery->AddEntity(handles[entityId]);
+            }
+        }
+        AddSystemToComponentLists(newQuery.get());
+        query = queries.emplace(std::type_index(typeid(TQuery)), std::move(newQuery)).first;
+    }
+    return static_cast<TQuery&>(*query->second);
+}
+
+template <typename TSystem, typename ...TArgs>
+void Registry::AddSystem (TArgs&& ...args) {
+    std::shared_ptr<TSystem> newSystem = std::make_shared<TSystem>(std::forward<TArgs>(args)...);
+    systems.insert(std::make_pair(std::type_index(typeid(TSystem)), newSystem));
+    AddSystemToComponentLists(newSystem.get());
+}
+
+template <typename TSystem>
+void Registry::RemoveSystem () {
+    auto system = systems.find(std::type_index(typeid(TSystem)));
+    RemoveSystemFromComponentLists(system->second.get());
+    systems.erase(system);
+}
+
+
+template <typename TSystem>
+bool Registry::HasSystem() const {
+    auto system = systems.find(std::type_index(typeid(TSystem)));
+    return *(std::static_pointer_cast<TSystem>(system->second));
+}
+
+template <typename TSystem>
+inline TSystem &Registry::GetSystem() const
+{
+    auto system = systems.find(std::type_index(typeid(TSystem)));
+    return *static_cast<TSystem*>(system->second.get());
+}
+
+template <typename TComponent, typename... TArgs>
+inline void Entity::AddComponent(TArgs &&...args)
+{
+    Registry::GetCurrent()->AddComponent<TComponent>(*this, std::forward<TArgs>(args)...);
+}
+
+template <typename TComponent>
+inline void Entity::RemoveComponent()
+{
+    Registry::GetCurrent()->RemoveComponent<TComponent>(*this);
+}
+
+template <typename TComponent>
+inline void Entity::MarkChanged() const
+{
+    Registry::GetCurrent()->MarkChanged<TComponent>(*this);
+}
+
+template <typename TComponent>
+inline bool Entity::HasComponent() const
+{
+    return Registry::GetCurrent()->HasComponent<TComponent>(*this);
+}
+
+template <typename TComponent>
+inline TComponent &Entity::GetComponent() const
+{
+   return Registry::GetCurrent()->GetComponent<TComponent>(*this);
+}
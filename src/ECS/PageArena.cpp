@@ -0,0 +1,34 @@
+#include "PageArena.h"
+#include <new>
+#include <string>
+#include "../Logger/Logger.h"
+
+PageArena::~PageArena() {
+    if (pagesInUse > 0) {
+        Logger::Err("Page arena destroyed with " + std::to_string(pagesInUse) + " pages still in use.");
+    }
+    Release();
+}
+
+void* PageArena::AllocatePage() {
+    pagesInUse++;
+    if (!freePages.empty()) {
+        void* page = freePages.back();
+        freePages.pop_back();
+        return page;
+    }
+    return ::operator new(ARENA_PAGE_SIZE, std::align_val_t(ARENA_PAGE_ALIGNMENT));
+}
+
+void PageArena::FreePage(void* page) {
+    pagesInUse--;
+    freePages.push_back(page);
+}
+
+void PageArena::Release() {
+    for (void* page: freePages) {
+        ::operator delete(page, std::align_val_t(ARENA_PAGE_ALIGNMENT));
+    }
+    freePages.clear();
+    freePages.shrink_to_fit();
+}
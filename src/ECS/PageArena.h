@@ -0,0 +1,36 @@
+#pragma once
+
+#include <vector>
+#include <cstddef>
+
+const size_t ARENA_PAGE_SIZE = 16 * 1024;
+const size_t ARENA_PAGE_ALIGNMENT = 64;
+
+// Hands out fixed-size, cache-line aligned pages of raw memory.
+// Freed pages are kept for reuse until Release() gives them back to the system.
+class PageArena {
+    private:
+        std::vector<void*> freePages;
+        size_t pagesInUse = 0;
+
+    public:
+        PageArena() = default;
+        ~PageArena();
+
+        PageArena(const PageArena&) = delete;
+        PageArena& operator=(const PageArena&) = delete;
+
+        void* AllocatePage();
+        void FreePage(void* page);
+
+        // Frees the cached pages, e.g. once a level has been unloaded
+        void Release();
+
+        size_t GetPagesInUse() const {
+            return pagesInUse;
+        }
+
+        size_t GetFreePages() const {
+            return freePages.size();
+        }
+};
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <memory>
+#include <utility>
+
+// Copy-on-write handle to a value that many components point at instead of each holding a copy
+// (e.g. the texture, size and layer every tile of a tilemap has in common). Copying the handle
+// shares the value; Write() first gives the handle its own copy if the value is still shared,
+// so customizing one entity never affects the others.
+template <typename T>
+class Shared {
+    private:
+        std::shared_ptr<T> value;
+
+        // Default-constructed handles all share one value, so they don't allocate
+        static const std::shared_ptr<T>& GetDefault() {
+            static const std::shared_ptr<T> defaultValue = std::make_shared<T>();
+            return defaultValue;
+        }
+
+    public:
+        Shared(): value(GetDefault()) {}
+        explicit Shared(T value): value(std::make_shared<T>(std::move(value))) {}
+
+        template <typename ...TArgs>
+        static Shared Make(TArgs&& ...args) {
+            return Shared(T{std::forward<TArgs>(args)...});
+        }
+
+        const T& operator*() const {
+            return *value;
+        }
+
+        const T* operator->() const {
+            return value.get();
+        }
+
+        // Mutable access to this handle's value, copied first if other handles share it
+        T& Write() {
+            if (value.use_count() > 1) {
+                value = std::make_shared<T>(*value);
+            }
+            return *value;
+        }
+
+        bool IsShared() const {
+            return value.use_count() > 1;
+        }
+
+        bool operator==(const Shared& other) const {
+            return value == other.value;
+        }
+
+        bool operator!=(const Shared& other) const {
+            return value != other.value;
+        }
+};
@@ -0,0 +1,87 @@
+#include "SystemScheduler.h"
+
+void SystemScheduler::AddStep(const std::string& name, const System& system, std::function<void()> run) {
+    steps.push_back({name, &system, std::move(run), {}, 0});
+    isScheduleDirty = true;
+}
+
+bool SystemScheduler::Conflicts(const System& a, const System& b) {
+    if (a.IsExclusive() || b.IsExclusive()) {
+        return true;
+    }
+    const Signature& aWrites = a.GetWriteSignature();
+    const Signature& bWrites = b.GetWriteSignature();
+    return (aWrites & (b.GetReadSignature() | bWrites)).any() || (bWrites & a.GetReadSignature()).any();
+}
+
+void SystemScheduler::BuildSchedule() {
+    for (size_t i = 0; i < steps.size(); i++) {
+        steps[i].dependencies.clear();
+        steps[i].stage = 0;
+        for (size_t j = 0; j < i; j++) {
+            if (Conflicts(*steps[i].system, *steps[j].system)) {
+                steps[i].dependencies.push_back(static_cast<int>(j));
+                steps[i].stage = std::max(steps[i].stage, steps[j].stage + 1);
+            }
+        }
+    }
+    isScheduleDirty = false;
+}
+
+void SystemScheduler::Run() {
+    if (isScheduleDirty) {
+        BuildSchedule();
+    }
+
+    if (jobSystem.GetWorkerCount() == 0) {
+        for (auto& step: steps) {
+            step.run();
+        }
+        return;
+    }
+
+    std::vector<JobHandle> jobs;
+    jobs.reserve(steps.size());
+    for (auto& step: steps) {
+        std::vector<JobHandle> dependencies;
+        for (int dependency: step.dependencies) {
+            dependencies.push_back(jobs[dependency]);
+        }
+        jobs.push_back(jobSystem.Schedule(step.run, dependencies));
+    }
+    jobSystem.WaitAll(jobs);
+}
+
+std::string SystemScheduler::Dump() {
+    if (isScheduleDirty) {
+        BuildSchedule();
+    }
+
+    int stageCount = 0;
+    for (const auto& step: steps) {
+        stageCount = std::max(stageCount, step.stage + 1);
+    }
+
+    std::string dump = "System schedule: " + std::to_string(stageCount) + " stages, " + std::to_string(jobSystem.GetWorkerCount()) + " worker threads";
+    for (int stage = 0; stage < stageCount; stage++) {
+        dump += "\n  stage " + std::to_string(stage) + ":";
+        for (const auto& step: steps) {
+            if (step.stage != stage) {
+                continue;
+            }
+            dump += "\n    " + step.name;
+            if (step.system->IsExclusive()) {
+                dump += " (exclusive)";
+            } else {
+                dump += " reads " + step.system->GetReadSignature().ToString() + " writes " + step.system->GetWriteSignature().ToString();
+            }
+            if (!step.dependencies.empty()) {
+                dump += " after";
+                for (int dependency: step.dependencies) {
+                    dump += " " + steps[dependency].name;
+                }
+            }
+        }
+    }
+    return dump;
+}
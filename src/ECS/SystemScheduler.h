@@ -0,0 +1,42 @@
+#pragma once
+
+#include "ECS.h"
+#include "../Jobs/JobSystem.h"
+#include <string>
+#include <vector>
+#include <functional>
+
+// Runs the per-frame system updates as jobs, putting systems whose declared component access
+// doesn't conflict side by side on the job system's workers.
+// Steps are considered in the order they were added: a step depends on every earlier step
+// it conflicts with (one writes what the other reads or writes, or either is exclusive),
+// which gives a deterministic dependency graph.
+class SystemScheduler {
+    private:
+        struct Step {
+            std::string name;
+            const System* system;
+            std::function<void()> run;
+            std::vector<int> dependencies;
+            int stage;
+        };
+
+        JobSystem& jobSystem;
+        std::vector<Step> steps;
+        bool isScheduleDirty = false;
+
+        static bool Conflicts(const System& a, const System& b);
+        void BuildSchedule();
+
+    public:
+        SystemScheduler(JobSystem& jobSystem): jobSystem(jobSystem) {}
+
+        void AddStep(const std::string& name, const System& system, std::function<void()> run);
+
+        // Without worker threads every step runs on the calling thread, in the order added
+        void Run();
+
+        // Human-readable description of the graph as stages (steps whose dependencies
+        // are all in earlier stages) and each step's component access
+        std::string Dump();
+};
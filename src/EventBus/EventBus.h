@@ -2,48 +2,351 @@
 
 #include "../Logger/Logger.h"
 #include "Event.h"
-#include <map>
-#include <typeindex>
-#include <list>
-#include <functional>
+#include "EventDelegate.h"
+#include <vector>
+#include <memory>
+#include <cstdint>
+#include <algorithm>
+#include <cstddef>
+#include <type_traits>
+#include <iterator>
+#include <thread>
+#include <mutex>
+#include <atomic>
 
-class IEventCallback {
+// Event types can pin their id below this at compile time (see EventIds.h)
+const int NUM_STATIC_EVENT_IDS = 16;
+
+template <typename TEvent, typename = void>
+struct HasStaticEventId : std::false_type {};
+
+template <typename TEvent>
+struct HasStaticEventId<TEvent, std::void_t<decltype(TEvent::StaticId)>> : std::true_type {};
+
+template <typename TEvent, typename = void>
+struct HasEventOrderKey : std::false_type {};
+
+template <typename TEvent>
+struct HasEventOrderKey<TEvent, std::void_t<decltype(std::declval<const TEvent&>().GetOrderKey())>> : std::true_type {};
+
+// Identifies a subscription so it can be cancelled with EventBus::Unsubscribe
+class EventSubscription {
     private:
-        virtual void Call(Event& e) = 0;
+        int eventTypeId = -1;
+        int channel = 0;
+        uint32_t id = 0;
+
+        friend class EventBus;
+
     public:
-        virtual ~IEventCallback() = default;
+        EventSubscription() = default;
 
-        void Execute(Event& e) {
-            Call(e);
+        bool IsValid() const {
+            return id != 0;
         }
 };
 
-template <typename TOwner, typename TEvent>
-class EventCallback: public IEventCallback {
+// The events of one type delivered together at EventBus::DispatchQueuedEvents
+template <typename TEvent>
+class EventSpan {
     private:
-        typedef void (TOwner::*CallbackFunction)(TEvent&);
+        const TEvent* events;
+        size_t count;
 
-        TOwner* ownerInstance;
-        CallbackFunction callbackFunction;
+    public:
+        EventSpan(const TEvent* events, size_t count): events(events), count(count) {}
 
-        virtual void Call(Event& e) override {
-            std::invoke(callbackFunction, ownerInstance, static_cast<TEvent&>(e));
+        const TEvent* begin() const {
+            return events;
         }
 
-    public:
-        EventCallback(TOwner* ownerInstance, CallbackFunction callbackFunction ) {
-            this->ownerInstance = ownerInstance;
-            this->callbackFunction = callbackFunction;
+        const TEvent* end() const {
+            return events + count;
         }
 
-        virtual ~EventCallback() override = default;
-};
+        const TEvent& operator[](size_t index) const {
+            return events[index];
+        }
 
-typedef std::list<std::unique_ptr<IEventCallback>> EventHandlers;
+        size_t size() const {
+            return count;
+        }
+
+        bool empty() const {
+            return count == 0;
+        }
+};
 
+// Subscriptions persist until they're cancelled: subscribe once (e.g. when the systems are set up)
+// instead of every frame. Each event type keeps its handlers in one contiguous array, so emitting
+// an event walks that array and doesn't allocate. Events are constructed once and handlers get them
+// by const reference.
+//
+// Events are either emitted, which calls the handlers right away, or queued, which appends them to
+// a contiguous buffer for their type that DispatchQueuedEvents delivers at a sync point. Batch
+// handlers (SubscribeToEvents) get all the queued events of their type in a single call.
+//
+// QueueEvent can be called from several threads at once (e.g. from a ParallelEach): each thread
+// appends to its own buffer without locking. The buffers are merged at the sync point and, for event
+// types with a `GetOrderKey()`, sorted by it, so handlers see the same order however the work was
+// split between threads. Everything else (subscribing, emitting, dispatching) belongs to one thread
+// at a time, and never while other threads are queueing.
+//
+// Queued events can also be routed to a channel: a small integer chosen by whoever queues them
+// (e.g. one per pair of collision layers). Channel handlers only get the events queued on their
+// channel; plain subscriptions are on channel 0.
 class EventBus {
     private:
-        std::map<std::type_index, std::unique_ptr<EventHandlers>> subscribers;
+        struct EventHandler {
+            // 0 once unsubscribed while the event was being emitted (it's erased afterwards)
+            uint32_t subscriptionId;
+            // Batch handlers get all the queued events of the type in one call
+            bool isBatch;
+            EventDelegate delegate;
+        };
+
+        struct EventHandlers;
+
+        class IEventQueue {
+            public:
+                virtual ~IEventQueue() = default;
+                virtual bool IsEmpty() const = 0;
+                virtual void Dispatch(EventHandlers& eventHandlers) = 0;
+        };
+
+        struct EventHandlers {
+            std::vector<EventHandler> handlers;
+            // Subscribed from inside a handler, appended once the emission is over
+            std::vector<EventHandler> pendingHandlers;
+            int emitDepth = 0;
+            bool hasCancelledHandlers = false;
+            // Created by the first subscription, so queueing never has to create anything
+            std::unique_ptr<IEventQueue> queue;
+            // Handlers of the type's other channels, indexed by channel (these lists are channel 0)
+            std::vector<std::unique_ptr<EventHandlers>> channels;
+        };
+
+        template <typename TEvent>
+        class EventQueue: public IEventQueue {
+            private:
+                struct ProducerBuffer {
+                    std::thread::id threadId;
+                    std::vector<TEvent> events;
+                };
+
+                // Each thread caches the buffers it found, keyed by queue serial. The channels of a type are
+                // created one after another, so their serials are consecutive and land in distinct slots.
+                static constexpr size_t CACHED_BUFFERS_PER_THREAD = 32;
+
+                struct CachedBuffer {
+                    uint64_t serial = 0;
+                    ProducerBuffer* buffer = nullptr;
+                };
+
+                // Identifies a queue for the threads' cached buffer lookups (addresses get reused)
+                static uint64_t NextSerial() {
+                    static std::atomic<uint64_t> nextSerial{1};
+                    return nextSerial++;
+                }
+
+                const uint64_t serial = NextSerial();
+                // One per thread that has queued events of this type; the lock is only taken to add one
+                std::vector<std::unique_ptr<ProducerBuffer>> producerBuffers;
+                std::mutex producerBuffersMutex;
+                // The merged batch being delivered: handlers queue into the emptied buffers for the next sync point
+                std::vector<TEvent> dispatchedEvents;
+                bool hasWarnedAboutOrder = false;
+
+                ProducerBuffer& GetProducerBuffer() {
+                    static thread_local CachedBuffer cachedBuffers[CACHED_BUFFERS_PER_THREAD];
+                    CachedBuffer& cached = cachedBuffers[serial % CACHED_BUFFERS_PER_THREAD];
+                    if (cached.serial == serial) {
+                        return *cached.buffer;
+                    }
+
+                    std::lock_guard<std::mutex> lock(producerBuffersMutex);
+                    const auto threadId = std::this_thread::get_id();
+                    auto buffer = std::find_if(producerBuffers.begin(), producerBuffers.end(), [threadId](const std::unique_ptr<ProducerBuffer>& producerBuffer) {
+                        return producerBuffer->threadId == threadId;
+                    });
+                    if (buffer == producerBuffers.end()) {
+                        producerBuffers.push_back(std::make_unique<ProducerBuffer>());
+                        producerBuffers.back()->threadId = threadId;
+                        buffer = producerBuffers.end() - 1;
+                    }
+                    cached = {serial, buffer->get()};
+                    return *cached.buffer;
+                }
+
+                // Threads append in whatever order they happened to run, so fix the order before anyone sees it
+                void MergeProducerBuffers() {
+                    int producerCount = 0;
+                    for (auto& buffer: producerBuffers) {
+                        if (buffer->events.empty()) {
+                            continue;
+                        }
+                        producerCount++;
+                        dispatchedEvents.insert(dispatchedEvents.end(), std::make_move_iterator(buffer->events.begin()), std::make_move_iterator(buffer->events.end()));
+                        buffer->events.clear();
+                    }
+
+                    if constexpr (HasEventOrderKey<TEvent>::value) {
+                        const auto byOrderKey = [](const TEvent& a, const TEvent& b) {
+                            return a.GetOrderKey() < b.GetOrderKey();
+                        };
+                        if (!std::is_sorted(dispatchedEvents.begin(), dispatchedEvents.end(), byOrderKey)) {
+                            std::stable_sort(dispatchedEvents.begin(), dispatchedEvents.end(), byOrderKey);
+                        }
+                    } else if (producerCount > 1 && !hasWarnedAboutOrder) {
+                        Logger::Err("Events queued from several threads have no GetOrderKey(), their order depends on thread timing.");
+                        hasWarnedAboutOrder = true;
+                    }
+                }
+
+            public:
+                template <typename ...TArgs>
+                void Push(TArgs&& ...args) {
+                    GetProducerBuffer().events.emplace_back(std::forward<TArgs>(args)...);
+                }
+
+                bool IsEmpty() const override {
+                    for (auto& buffer: producerBuffers) {
+                        if (!buffer->events.empty()) {
+                            return false;
+                        }
+                    }
+                    return true;
+                }
+
+                void Dispatch(EventHandlers& eventHandlers) override {
+                    MergeProducerBuffers();
+                    for (size_t i = 0; i < eventHandlers.handlers.size(); i++) {
+                        const EventHandler& handler = eventHandlers.handlers[i];
+                        if (handler.subscriptionId == 0) {
+                            continue;
+                        }
+                        if (handler.isBatch) {
+                            handler.delegate(dispatchedEvents.data(), dispatchedEvents.size());
+                        } else {
+                            // Stops if the handler unsubscribes partway through the batch
+                            for (size_t j = 0; j < dispatchedEvents.size() && handler.subscriptionId != 0; j++) {
+                                handler.delegate(&dispatchedEvents[j], 1);
+                            }
+                        }
+                    }
+                    // Keeps its capacity, so queueing doesn't allocate once the buffers have warmed up
+                    dispatchedEvents.clear();
+                }
+        };
+
+        // Indexed by event type id; the lists are heap allocated so handlers can subscribe to new event types
+        std::vector<std::unique_ptr<EventHandlers>> handlersPerEventType;
+        uint32_t nextSubscriptionId = 1;
+        bool isDispatchingQueuedEvents = false;
+
+        static int NextEventTypeId() {
+            static int nextId = NUM_STATIC_EVENT_IDS;
+            return nextId++;
+        }
+
+        // Event types declaring `static constexpr int StaticId` use it; the others get an id at
+        // runtime, in first-use order, from the range above NUM_STATIC_EVENT_IDS
+        template <typename TEvent>
+        static int GetEventTypeId() {
+            if constexpr (HasStaticEventId<TEvent>::value) {
+                static_assert(TEvent::StaticId >= 0 && TEvent::StaticId < NUM_STATIC_EVENT_IDS, "Static event ids must be below NUM_STATIC_EVENT_IDS");
+                return TEvent::StaticId;
+            } else {
+                static const int id = NextEventTypeId();
+                return id;
+            }
+        }
+
+        EventHandlers& GetEventHandlers(int eventTypeId, int channel) {
+            if (eventTypeId >= static_cast<int>(handlersPerEventType.size())) {
+                handlersPerEventType.resize(eventTypeId + 1);
+            }
+            if (!handlersPerEventType[eventTypeId]) {
+                handlersPerEventType[eventTypeId] = std::make_unique<EventHandlers>();
+            }
+            if (channel == 0) {
+                return *handlersPerEventType[eventTypeId];
+            }
+
+            auto& channels = handlersPerEventType[eventTypeId]->channels;
+            if (channel >= static_cast<int>(channels.size())) {
+                channels.resize(channel + 1);
+            }
+            if (!channels[channel]) {
+                channels[channel] = std::make_unique<EventHandlers>();
+            }
+            return *channels[channel];
+        }
+
+        // Doesn't create anything, so it's safe while other threads are queueing
+        EventHandlers* FindEventHandlers(int eventTypeId, int channel) const {
+            if (eventTypeId < 0 || eventTypeId >= static_cast<int>(handlersPerEventType.size()) || !handlersPerEventType[eventTypeId]) {
+                return nullptr;
+            }
+            if (channel == 0) {
+                return handlersPerEventType[eventTypeId].get();
+            }
+
+            const auto& channels = handlersPerEventType[eventTypeId]->channels;
+            return channel > 0 && channel < static_cast<int>(channels.size()) ? channels[channel].get() : nullptr;
+        }
+
+        template <typename TEvent>
+        EventSubscription Subscribe(int channel, bool isBatch, EventDelegate delegate) {
+            const int eventTypeId = GetEventTypeId<TEvent>();
+            EventSubscription subscription;
+            subscription.eventTypeId = eventTypeId;
+            subscription.channel = channel;
+            subscription.id = nextSubscriptionId++;
+
+            EventHandlers& eventHandlers = GetEventHandlers(eventTypeId, channel);
+            if (!eventHandlers.queue) {
+                eventHandlers.queue = std::make_unique<EventQueue<TEvent>>();
+            }
+            auto& handlers = eventHandlers.emitDepth > 0 ? eventHandlers.pendingHandlers : eventHandlers.handlers;
+            handlers.push_back({subscription.id, isBatch, delegate});
+            return subscription;
+        }
+
+        template <typename TOwner, typename TCallback>
+        struct MemberTarget {
+            TOwner* ownerInstance;
+            TCallback callbackFunction;
+        };
+
+        static void DispatchQueue(EventHandlers& eventHandlers) {
+            if (!eventHandlers.queue || eventHandlers.queue->IsEmpty()) {
+                return;
+            }
+
+            eventHandlers.emitDepth++;
+            eventHandlers.queue->Dispatch(eventHandlers);
+            if (--eventHandlers.emitDepth == 0) {
+                FinishEmitting(eventHandlers);
+            }
+        }
+
+        static void FinishEmitting(EventHandlers& eventHandlers) {
+            if (eventHandlers.hasCancelledHandlers) {
+                auto& handlers = eventHandlers.handlers;
+                handlers.erase(std::remove_if(handlers.begin(), handlers.end(), [](const EventHandler& handler) {
+                    return handler.subscriptionId == 0;
+                }), handlers.end());
+                eventHandlers.hasCancelledHandlers = false;
+            }
+            if (!eventHandlers.pendingHandlers.empty()) {
+                for (auto& handler: eventHandlers.pendingHandlers) {
+                    eventHandlers.handlers.push_back(std::move(handler));
+                }
+                eventHandlers.pendingHandlers.clear();
+            }
+        }
+
     public:
         EventBus() {
             Logger::Log("EventBus created.");
@@ -52,31 +355,156 @@ class EventBus {
              Logger::Log("EventBus destroyed.");
         }
 
+        // Cancels every subscription and drops the queued events
         void Reset() {
-            subscribers.clear();
+            handlersPerEventType.clear();
+        }
+
+        template <typename TEvent, typename TOwner>
+        EventSubscription SubscribeToEvent(TOwner* ownerInstance, void (TOwner::*callbackFunction)(const TEvent&)) {
+            return SubscribeToEvent<TEvent>(0, ownerInstance, callbackFunction);
+        }
+
+        template <typename TEvent, typename TOwner>
+        EventSubscription SubscribeToEvent(int channel, TOwner* ownerInstance, void (TOwner::*callbackFunction)(const TEvent&)) {
+            using Target = MemberTarget<TOwner, void (TOwner::*)(const TEvent&)>;
+            return Subscribe<TEvent>(channel, false, EventDelegate(Target{ownerInstance, callbackFunction}, [](const void* target, const Event* events, size_t count) {
+                const Target& member = EventDelegate::GetTarget<Target>(target);
+                for (size_t i = 0; i < count; i++) {
+                    (member.ownerInstance->*member.callbackFunction)(static_cast<const TEvent*>(events)[i]);
+                }
+            }));
+        }
+
+        // Any callable taking `const TEvent&` that fits in an EventDelegate (e.g. a lambda capturing a few pointers)
+        template <typename TEvent, typename TCallable>
+        EventSubscription SubscribeToEvent(TCallable callable) {
+            return Subscribe<TEvent>(0, false, EventDelegate(callable, [](const void* target, const Event* events, size_t count) {
+                const TCallable& callback = EventDelegate::GetTarget<TCallable>(target);
+                for (size_t i = 0; i < count; i++) {
+                    callback(static_cast<const TEvent*>(events)[i]);
+                }
+            }));
+        }
+
+        // Batch handler: called once per DispatchQueuedEvents with every queued event of the type
+        // (emitted events still reach it, one at a time)
+        template <typename TEvent, typename TOwner>
+        EventSubscription SubscribeToEvents(TOwner* ownerInstance, void (TOwner::*callbackFunction)(EventSpan<TEvent>)) {
+            return SubscribeToEvents<TEvent>(0, ownerInstance, callbackFunction);
         }
 
         template <typename TEvent, typename TOwner>
-        void SubscribeToEvent(TOwner* ownerInstance, void (TOwner::*callbackFunction)(TEvent&)) {
+        EventSubscription SubscribeToEvents(int channel, TOwner* ownerInstance, void (TOwner::*callbackFunction)(EventSpan<TEvent>)) {
+            using Target = MemberTarget<TOwner, void (TOwner::*)(EventSpan<TEvent>)>;
+            return Subscribe<TEvent>(channel, true, EventDelegate(Target{ownerInstance, callbackFunction}, [](const void* target, const Event* events, size_t count) {
+                const Target& member = EventDelegate::GetTarget<Target>(target);
+                (member.ownerInstance->*member.callbackFunction)(EventSpan<TEvent>(static_cast<const TEvent*>(events), count));
+            }));
+        }
 
-            if(!subscribers[typeid(TEvent)].get()) {
-                subscribers[typeid(TEvent)] = std::make_unique<EventHandlers>();
+        // Safe to call from inside a handler, including the one being cancelled
+        void Unsubscribe(EventSubscription& subscription) {
+            EventHandlers* subscribedHandlers = subscription.IsValid() ? FindEventHandlers(subscription.eventTypeId, subscription.channel) : nullptr;
+            if (!subscribedHandlers) {
+                subscription = EventSubscription();
+                return;
             }
 
-            auto subscriber = std::make_unique<EventCallback<TOwner, TEvent>>(ownerInstance, callbackFunction);
-            subscribers[typeid(TEvent)]->push_back(std::move(subscriber));
+            EventHandlers& eventHandlers = *subscribedHandlers;
+            const auto matches = [&subscription](const EventHandler& handler) {
+                return handler.subscriptionId == subscription.id;
+            };
+
+            auto& pendingHandlers = eventHandlers.pendingHandlers;
+            pendingHandlers.erase(std::remove_if(pendingHandlers.begin(), pendingHandlers.end(), matches), pendingHandlers.end());
+
+            auto& handlers = eventHandlers.handlers;
+            auto handler = std::find_if(handlers.begin(), handlers.end(), matches);
+            if (handler != handlers.end()) {
+                if (eventHandlers.emitDepth > 0) {
+                    handler->subscriptionId = 0;
+                    eventHandlers.hasCancelledHandlers = true;
+                } else {
+                    handlers.erase(handler);
+                }
+            }
+            subscription = EventSubscription();
         }
 
         template <typename TEvent, typename ...TArgs>
         void EmitEvent(TArgs&& ...args) {
-            auto handlers = subscribers[typeid(TEvent)].get();
+            const int eventTypeId = GetEventTypeId<TEvent>();
+            if (eventTypeId >= static_cast<int>(handlersPerEventType.size()) || !handlersPerEventType[eventTypeId]) {
+                return;
+            }
+
+            EventHandlers& eventHandlers = *handlersPerEventType[eventTypeId];
+            if (eventHandlers.handlers.empty()) {
+                return;
+            }
+
+            const TEvent event(std::forward<TArgs>(args)...);
+
+            // Indexed loop: handlers may unsubscribe (which only marks them while we're here)
+            eventHandlers.emitDepth++;
+            for (size_t i = 0; i < eventHandlers.handlers.size(); i++) {
+                if (eventHandlers.handlers[i].subscriptionId != 0) {
+                    eventHandlers.handlers[i].delegate(&event, 1);
+                }
+            }
+            if (--eventHandlers.emitDepth == 0) {
+                FinishEmitting(eventHandlers);
+            }
+        }
 
-            if(handlers) {
-                for(auto it = handlers->begin(); it != handlers->end(); it++) {
-                    auto handler = it->get();
-                    TEvent event(std::forward<TArgs>(args)...);
-                    handler->Execute(event);
+        // Whether anything listens to the event type on the channel (so producers can skip work)
+        template <typename TEvent>
+        bool HasSubscribers(int channel = 0) const {
+            const EventHandlers* eventHandlers = FindEventHandlers(GetEventTypeId<TEvent>(), channel);
+            return eventHandlers && !(eventHandlers->handlers.empty() && eventHandlers->pendingHandlers.empty());
+        }
+
+        // Stores the event until the next DispatchQueuedEvents instead of handling it now.
+        // Safe to call from any thread, concurrently, without locking.
+        template <typename TEvent, typename ...TArgs>
+        void QueueEvent(TArgs&& ...args) {
+            QueueEventOnChannel<TEvent>(0, std::forward<TArgs>(args)...);
+        }
+
+        template <typename TEvent, typename ...TArgs>
+        void QueueEventOnChannel(int channel, TArgs&& ...args) {
+            EventHandlers* eventHandlers = FindEventHandlers(GetEventTypeId<TEvent>(), channel);
+            if (!eventHandlers || (eventHandlers->handlers.empty() && eventHandlers->pendingHandlers.empty())) {
+                return;
+            }
+            static_cast<EventQueue<TEvent>&>(*eventHandlers->queue).Push(std::forward<TArgs>(args)...);
+        }
+
+        // The sync point: delivers the queued events type by type, in the order they were queued
+        // (or by their order keys). Events queued by the handlers wait for the next call.
+        void DispatchQueuedEvents() {
+            if (isDispatchingQueuedEvents) {
+                Logger::Err("DispatchQueuedEvents called from inside an event handler.");
+                return;
+            }
+            isDispatchingQueuedEvents = true;
+
+            // Indexed loops: handlers may subscribe to new event types and channels (the lists themselves don't move)
+            for (size_t eventTypeId = 0; eventTypeId < handlersPerEventType.size(); eventTypeId++) {
+                if (!handlersPerEventType[eventTypeId]) {
+                    continue;
+                }
+
+                EventHandlers& eventHandlers = *handlersPerEventType[eventTypeId];
+                DispatchQueue(eventHandlers);
+                for (size_t channel = 1; channel < eventHandlers.channels.size(); channel++) {
+                    if (eventHandlers.channels[channel]) {
+                        DispatchQueue(*eventHandlers.channels[channel]);
+                    }
                 }
             }
+
+            isDispatchingQueuedEvents = false;
         }
 };
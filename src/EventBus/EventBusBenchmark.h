@@ -0,0 +1,113 @@
+#pragma once
+
+#include "EventBus.h"
+#include "../Logger/Logger.h"
+#include <chrono>
+#include <string>
+
+// Measures what EmitEvent costs with 1, 4 and 16 handlers subscribed, and what QueueEvent costs when
+// the events are spread over 1, 4 and 16 channels (run with --benchmark-events)
+class EventBusBenchmark {
+    private:
+        struct BenchmarkEvent: public Event {
+            int value;
+            BenchmarkEvent(int value): value(value) {}
+        };
+
+        struct Counter {
+            long long sum = 0;
+
+            void OnEvent(const BenchmarkEvent& event) {
+                sum += event.value;
+            }
+
+            void OnEvents(EventSpan<BenchmarkEvent> events) {
+                for (auto& event: events) {
+                    sum += event.value;
+                }
+            }
+        };
+
+        // Queued the way CollisionSystem queues routed collisions: consecutive events go to different channels
+        static void RunQueued(int channelCount) {
+            EventBus eventBus;
+            Counter counters[16];
+            for (int i = 0; i < channelCount; i++) {
+                eventBus.SubscribeToEvents<BenchmarkEvent>(i, &counters[i], &Counter::OnEvents);
+            }
+
+            double queueNanoseconds = 0.0;
+            double dispatchNanoseconds = 0.0;
+            for (int frame = 0; frame < QUEUED_FRAMES + 1; frame++) {
+                const auto start = std::chrono::steady_clock::now();
+                for (int i = 0; i < EVENTS_PER_FRAME; i++) {
+                    eventBus.QueueEventOnChannel<BenchmarkEvent>(i % channelCount, i);
+                }
+                const auto queued = std::chrono::steady_clock::now();
+                eventBus.DispatchQueuedEvents();
+                const auto dispatched = std::chrono::steady_clock::now();
+
+                // (the first frame grows the buffers)
+                if (frame > 0) {
+                    queueNanoseconds += std::chrono::duration<double, std::nano>(queued - start).count();
+                    dispatchNanoseconds += std::chrono::duration<double, std::nano>(dispatched - queued).count();
+                }
+            }
+
+            long long checksum = 0;
+            for (int i = 0; i < channelCount; i++) {
+                checksum += counters[i].sum;
+            }
+
+            const double eventCount = static_cast<double>(QUEUED_FRAMES) * EVENTS_PER_FRAME;
+            Logger::Log(
+                "QueueEvent over " + std::to_string(channelCount) + " channel(s): " +
+                std::to_string(queueNanoseconds / eventCount) + " ns per event queued, " +
+                std::to_string(dispatchNanoseconds / eventCount) + " ns per event dispatched" +
+                " (checksum " + std::to_string(checksum) + ")."
+            );
+        }
+
+        static constexpr int EMITS_PER_RUN = 1000000;
+        static constexpr int EVENTS_PER_FRAME = 10000;
+        static constexpr int QUEUED_FRAMES = 100;
+
+    public:
+        static void Run() {
+            for (int handlerCount: {1, 4, 16}) {
+                EventBus eventBus;
+                Counter counters[16];
+                for (int i = 0; i < handlerCount; i++) {
+                    eventBus.SubscribeToEvent<BenchmarkEvent>(&counters[i], &Counter::OnEvent);
+                }
+
+                // Warm up, so the timed loop doesn't include first-use costs
+                for (int i = 0; i < EMITS_PER_RUN / 10; i++) {
+                    eventBus.EmitEvent<BenchmarkEvent>(i);
+                }
+
+                const auto start = std::chrono::steady_clock::now();
+                for (int i = 0; i < EMITS_PER_RUN; i++) {
+                    eventBus.EmitEvent<BenchmarkEvent>(i);
+                }
+                const auto end = std::chrono::steady_clock::now();
+
+                long long checksum = 0;
+                for (int i = 0; i < handlerCount; i++) {
+                    checksum += counters[i].sum;
+                }
+
+                const double nanoseconds = std::chrono::duration<double, std::nano>(end - start).count();
+                Logger::Log(
+                    "EmitEvent with " + std::to_string(handlerCount) + " handler(s): " +
+                    std::to_string(nanoseconds / EMITS_PER_RUN) + " ns per event, " +
+                    std::to_string(nanoseconds / (static_cast<double>(EMITS_PER_RUN) * handlerCount)) + " ns per handler call" +
+                    " (checksum " + std::to_string(checksum) + ")."
+                );
+            }
+
+            for (int channelCount: {1, 4, 16}) {
+                RunQueued(channelCount);
+            }
+        }
+};
@@ -0,0 +1,44 @@
+#pragma once
+
+#include "Event.h"
+#include <cstddef>
+#include <new>
+#include <type_traits>
+
+// Calls an event handler through a single function pointer. The handler's target (an object and
+// one of its member functions, or a small lambda) is copied into inline storage, so binding a
+// handler never allocates and calling it costs one indirect call.
+class EventDelegate {
+    public:
+        static constexpr size_t STORAGE_SIZE = 3 * sizeof(void*);
+
+        // Gets the stored target and `count` consecutive events of the handler's type
+        using Invoker = void (*)(const void* target, const Event* events, size_t count);
+
+        EventDelegate() = default;
+
+        template <typename TTarget>
+        EventDelegate(const TTarget& target, Invoker invoker): invoker(invoker) {
+            static_assert(sizeof(TTarget) <= STORAGE_SIZE, "Event handler target is too large, capture less");
+            static_assert(alignof(TTarget) <= alignof(void*), "Event handler target is over-aligned");
+            static_assert(std::is_trivially_copyable_v<TTarget> && std::is_trivially_destructible_v<TTarget>, "Event handler targets must be trivially copyable (capture pointers or references)");
+            new (storage) TTarget(target);
+        }
+
+        template <typename TTarget>
+        static const TTarget& GetTarget(const void* target) {
+            return *std::launder(static_cast<const TTarget*>(target));
+        }
+
+        void operator()(const Event* events, size_t count) const {
+            invoker(storage, events, count);
+        }
+
+        explicit operator bool() const {
+            return invoker != nullptr;
+        }
+
+    private:
+        alignas(void*) unsigned char storage[STORAGE_SIZE] = {};
+        Invoker invoker = nullptr;
+};
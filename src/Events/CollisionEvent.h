@@ -2,10 +2,18 @@
 
 #include "../ECS/ECS.h"
 #include "../EventBus/Event.h"
+#include "EventIds.h"
 
 class CollisionEvent: public Event {
     public:
+        static constexpr int StaticId = COLLISION_EVENT_ID;
+
         Entity a;
         Entity b;
         CollisionEvent(Entity a, Entity b): a(a), b(b) {}
+
+        // Collisions are found in parallel: sorting them by entity ids keeps the handlers deterministic
+        uint64_t GetOrderKey() const {
+            return (static_cast<uint64_t>(a.GetId()) << 32) | static_cast<uint64_t>(b.GetId());
+        }
 };
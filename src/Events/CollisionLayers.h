@@ -0,0 +1,84 @@
+#pragma once
+
+#include "../ECS/ECS.h"
+#include "../Logger/Logger.h"
+#include <string>
+#include <vector>
+#include <unordered_map>
+
+// Collision layers are named after the tags and groups entities are given ("player", "enemies").
+// Subscribing to a pair of layers reserves an EventBus channel that only carries the CollisionEvents
+// between them, ordered so that `a` is in the first layer and `b` in the second. The collision system
+// finds each entity's layer by its tag id (or else its group id) and each pair's channel in a flat
+// table, so routing a collision is a couple of array reads and nothing compares names.
+class CollisionLayers {
+    public:
+        static constexpr int MAX_LAYERS = 32;
+        static constexpr int NO_LAYER = -1;
+        static constexpr int NO_CHANNEL = 0;
+
+        static int GetLayerId(const std::string& name) {
+            auto layer = layerIds.find(name);
+            if (layer != layerIds.end()) {
+                return layer->second;
+            }
+
+            const int layerId = static_cast<int>(layerIds.size());
+            if (layerId >= MAX_LAYERS) {
+                Logger::Err("Too many collision layers, increase CollisionLayers::MAX_LAYERS.");
+                return NO_LAYER;
+            }
+            layerIds.emplace(name, layerId);
+            SetLayer(layerPerTag, Registry::GetTagId(name), layerId);
+            SetLayer(layerPerGroup, Registry::GetGroupId(name), layerId);
+            return layerId;
+        }
+
+        // The channel to subscribe to for collisions between an entity in layerA (a) and one in layerB (b)
+        static int GetPairChannel(const std::string& layerA, const std::string& layerB) {
+            const int a = GetLayerId(layerA);
+            const int b = GetLayerId(layerB);
+            if (a == NO_LAYER || b == NO_LAYER) {
+                // (a channel nothing is ever routed to)
+                return nextChannel++;
+            }
+
+            int& channel = channelPerLayerPair[a * MAX_LAYERS + b];
+            if (channel == NO_CHANNEL) {
+                channel = nextChannel++;
+            }
+            return channel;
+        }
+
+        // NO_CHANNEL when nobody subscribed to the (ordered) pair
+        static int GetPairChannel(int layerA, int layerB) {
+            return channelPerLayerPair[layerA * MAX_LAYERS + layerB];
+        }
+
+        static int GetEntityLayer(const Registry& registry, Entity entity) {
+            const int tagId = registry.GetEntityTagId(entity);
+            if (tagId >= 0 && tagId < static_cast<int>(layerPerTag.size()) && layerPerTag[tagId] != NO_LAYER) {
+                return layerPerTag[tagId];
+            }
+            const int groupId = registry.GetEntityGroupId(entity);
+            if (groupId >= 0 && groupId < static_cast<int>(layerPerGroup.size())) {
+                return layerPerGroup[groupId];
+            }
+            return NO_LAYER;
+        }
+
+    private:
+        static inline std::unordered_map<std::string, int> layerIds;
+        // Indexed by tag / group id
+        static inline std::vector<int> layerPerTag;
+        static inline std::vector<int> layerPerGroup;
+        static inline std::vector<int> channelPerLayerPair = std::vector<int>(MAX_LAYERS * MAX_LAYERS, NO_CHANNEL);
+        static inline int nextChannel = 1;
+
+        static void SetLayer(std::vector<int>& layers, int id, int layerId) {
+            if (id >= static_cast<int>(layers.size())) {
+                layers.resize(id + 1, NO_LAYER);
+            }
+            layers[id] = layerId;
+        }
+};
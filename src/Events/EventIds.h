@@ -0,0 +1,8 @@
+#pragma once
+
+// Compile-time ids of the engine's events (see EventBus::GetEventTypeId). They index the
+// bus's handler lists directly; only append new ids, below NUM_STATIC_EVENT_IDS.
+enum EventIds {
+    COLLISION_EVENT_ID = 0,
+    KEY_PRESSED_EVENT_ID = 1
+};
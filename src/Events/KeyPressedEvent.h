@@ -2,10 +2,13 @@
 
 #include "../ECS/ECS.h"
 #include "../EventBus/Event.h"
+#include "EventIds.h"
 #include <SDL2/SDL.h>
 
 class KeyPressedEvent: public Event {
     public:
+        static constexpr int StaticId = KEY_PRESSED_EVENT_ID;
+
         SDL_Keycode symbol;
         KeyPressedEvent(SDL_Keycode symbol): symbol(symbol) {}
 };
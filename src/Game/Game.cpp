@@ -15,6 +15,7 @@
 #include "../Systems/RenderTextSystem.h"
 #include "../Systems/RenderHealthBarSystem.h"
 #include "../Systems/ScriptSystem.h"
+#include "../Systems/SleepSystem.h"
 #include <iostream>
 #include "glm/glm.hpp"
 #include <SDL2/SDL.h>
@@ -25,13 +26,15 @@ int Game::windowHeight;
 int Game::mapWidth;
 int Game::mapHeight;
 
-Game::Game()
+Game::Game(StorageMode storageMode, int workerCount)
 {
     isDebug = false;
     isRunning = false;
-    registry = std::make_unique<Registry>();
+    registry = std::make_unique<Registry>(storageMode);
     assetStore = std::make_unique<AssetStore>();
     eventBus = std::make_unique<EventBus>();
+    jobSystem = std::make_unique<JobSystem>(workerCount);
+    scheduler = std::make_unique<SystemScheduler>(*jobSystem);
     Logger::Log("Game created.");
 }
 Game::~Game()
@@ -130,12 +133,47 @@ void Game::Setup()
     registry->AddSystem<RenderTextSystem>();
     registry->AddSystem<RenderHealthBarSystem>();
     registry->AddSystem<ScriptSystem>();
+    registry->AddSystem<SleepSystem>();
 
     registry->GetSystem<ScriptSystem>().CreateLuaBindings(lua);
 
+    // Subscriptions last until they're cancelled, so the systems subscribe once
+    registry->GetSystem<MovementSystem>().SubscribeToEvents(eventBus);
+    registry->GetSystem<DamageSystem>().SubscribeToEvents(eventBus);
+    registry->GetSystem<KeyboardControlSystem>().SubscribeToEvents(eventBus);
+    registry->GetSystem<ProjectileEmitSystem>().SubscribeToEvents(eventBus);
+
+    // The order systems are added in is the order conflicting systems run in
+    scheduler->AddStep("SleepSystem", registry->GetSystem<SleepSystem>(), [this]() {
+        registry->GetSystem<SleepSystem>().Update(registry, camera, deltaTime);
+    });
+    scheduler->AddStep("MovementSystem", registry->GetSystem<MovementSystem>(), [this]() {
+        registry->GetSystem<MovementSystem>().Update(registry, *jobSystem, deltaTime);
+    });
+    scheduler->AddStep("AnimationSystem", registry->GetSystem<AnimationSystem>(), [this]() {
+        registry->GetSystem<AnimationSystem>().Update(registry, *jobSystem);
+    });
+    scheduler->AddStep("CollisionSystem", registry->GetSystem<CollisionSystem>(), [this]() {
+        registry->GetSystem<CollisionSystem>().Update(registry, eventBus, *jobSystem);
+    });
+    scheduler->AddStep("ProjectileEmitSystem", registry->GetSystem<ProjectileEmitSystem>(), [this]() {
+        registry->GetSystem<ProjectileEmitSystem>().Update(registry);
+    });
+    scheduler->AddStep("CameraMovementSystem", registry->GetSystem<CameraMovementSystem>(), [this]() {
+        registry->GetSystem<CameraMovementSystem>().Update(registry, camera);
+    });
+    scheduler->AddStep("ProjectileLifecycleSystem", registry->GetSystem<ProjectileLifecycleSystem>(), [this]() {
+        registry->GetSystem<ProjectileLifecycleSystem>().Update(registry, *jobSystem);
+    });
+    scheduler->AddStep("ScriptSystem", registry->GetSystem<ScriptSystem>(), [this]() {
+        registry->GetSystem<ScriptSystem>().Update(registry, deltaTime, SDL_GetTicks());
+    });
+    Logger::Log(scheduler->Dump());
+
     LevelLoader loader;
     lua.open_libraries(sol::lib::base, sol::lib::math, sol::lib::os);
-    loader.LoadLevel(lua, registry, assetStore, renderer, 2);
+    loader.LoadLevel(lua, registry, assetStore, renderer, *jobSystem, 2);
+    Logger::Log(registry->GetStats().ToString());
 }
 
 void Game::Update()
@@ -146,38 +184,35 @@ void Game::Update()
         SDL_Delay(msToDelay);
     }
 
-    double deltaTime = (SDL_GetTicks() - msPreviousFrame) / 1000.0;
+    deltaTime = (SDL_GetTicks() - msPreviousFrame) / 1000.0;
 
     msPreviousFrame = SDL_GetTicks();
 
-    eventBus->Reset();
-
-    registry->GetSystem<MovementSystem>().SubscribeToEvents(eventBus);
-    registry->GetSystem<DamageSystem>().SubscribeToEvents(eventBus);
-    registry->GetSystem<KeyboardControlSystem>().SubscribeToEvents(eventBus);
-    registry->GetSystem<ProjectileEmitSystem>().SubscribeToEvents(eventBus);
+    jobSystem->ProcessMainThreadJobs();
 
     registry->Update();
 
-    registry->GetSystem<MovementSystem>().Update(deltaTime);
-    registry->GetSystem<AnimationSystem>().Update();
-    registry->GetSystem<CollisionSystem>().Update(eventBus);
-    registry->GetSystem<ProjectileEmitSystem>().Update(registry);
-    registry->GetSystem<CameraMovementSystem>().Update(camera);
-    registry->GetSystem<ProjectileLifecycleSystem>().Update();
-    registry->GetSystem<ScriptSystem>().Update(deltaTime, SDL_GetTicks());
+    scheduler->Run();
+
+    // Sync point for the events the systems queued while they ran
+    eventBus->DispatchQueuedEvents();
+
+    if (isDebug && SDL_GetTicks() - msPreviousStatsDump >= MS_PER_STATS_DUMP) {
+        Logger::Log(registry->GetStats().ToString());
+        msPreviousStatsDump = SDL_GetTicks();
+    }
 }
 void Game::Render()
 {
     SDL_SetRenderDrawColor(renderer, 21, 21, 21, 255);
     SDL_RenderClear(renderer);
 
-    registry->GetSystem<RenderSystem>().Update(renderer, assetStore, camera);
-    registry->GetSystem<RenderTextSystem>().Update(renderer, assetStore, camera);
-    registry->GetSystem<RenderHealthBarSystem>().Update(renderer, assetStore, camera);
+    registry->GetSystem<RenderSystem>().Update(registry, renderer, assetStore, camera);
+    registry->GetSystem<RenderTextSystem>().Update(registry, renderer, assetStore, camera);
+    registry->GetSystem<RenderHealthBarSystem>().Update(registry, renderer, assetStore, camera);
 
     if(isDebug) {
-        registry->GetSystem<RenderColliderSystem>().Update(renderer, camera);
+        registry->GetSystem<RenderColliderSystem>().Update(registry, renderer, camera);
     }
 
     SDL_RenderPresent(renderer);
@@ -1,6 +1,8 @@
 #pragma once
 
 #include "../ECS/ECS.h"
+#include "../ECS/SystemScheduler.h"
+#include "../Jobs/JobSystem.h"
 #include "../AssetStore/AssetStore.h"
 #include "../EventBus/EventBus.h"
 #include <SDL2/SDL.h>
@@ -10,12 +12,17 @@
 const int FPS = 60;
 const int MS_PER_FRAME = 1000 / FPS;
 
+// How often the registry stats are logged while in debug mode
+const int MS_PER_STATS_DUMP = 5000;
+
 class Game
 {
 private:
     bool isDebug;
     bool isRunning;
     int msPreviousFrame = 0;
+    int msPreviousStatsDump = 0;
+    double deltaTime = 0.0;
     SDL_Window *window;
     SDL_Renderer *renderer;
     SDL_Rect camera;
@@ -24,9 +31,11 @@ private:
     std::unique_ptr<Registry> registry;
     std::unique_ptr<AssetStore> assetStore;
     std::unique_ptr<EventBus> eventBus;
+    std::unique_ptr<JobSystem> jobSystem;
+    std::unique_ptr<SystemScheduler> scheduler;
 
 public:
-    Game();
+    Game(StorageMode storageMode = StorageMode::SparseSet, int workerCount = 0);
     ~Game();
     void Initialize();
     void Run();
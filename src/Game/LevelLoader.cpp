@@ -12,6 +12,7 @@
 #include "../Components/TextLabelComponent.h"
 #include "../Components/HealthComponent.h"
 #include "../Components/ScriptComponent.h"
+#include "../Components/SleepComponent.h"
 #include <fstream>
 #include <string>
 
@@ -28,6 +29,7 @@ void LevelLoader::LoadLevel(
     const std::unique_ptr<Registry>& registry,
     const std::unique_ptr<AssetStore>& assetStore,
     SDL_Renderer* renderer,
+    JobSystem& jobSystem,
     int levelNumber
 ) {
     sol::load_result script = lua.load_file("./assets/scripts/Level" + std::to_string(levelNumber) + ".lua");
@@ -44,6 +46,8 @@ void LevelLoader::LoadLevel(
     sol::table level = lua["Level"];
     sol::table assets = level["assets"];
 
+    // Textures decode in the background while the rest of the level is read
+    std::vector<JobHandle> textureJobs;
     int i = 0;
     while (true) {
         sol::optional<sol::table> hasAsset = assets[i];
@@ -54,8 +58,8 @@ void LevelLoader::LoadLevel(
         std::string assetType = asset["type"];
         std::string assetId = asset["id"];
         if (assetType == "texture") {
-            assetStore->AddTexture(renderer, assetId, asset["file"]);
-            Logger::Log("A new texture asset was added to the asset store, id: " + assetId);
+            textureJobs.push_back(assetStore->AddTextureAsync(jobSystem, renderer, assetId, asset["file"]));
+            Logger::Log("A new texture asset is being added to the asset store, id: " + assetId);
         }
         if (assetType == "font") {
             assetStore->AddFont(assetId, asset["file"], asset["font_size"]);
@@ -74,6 +78,8 @@ void LevelLoader::LoadLevel(
     int mapNumCols = map["num_cols"];
     int tileSize = map["tile_size"];
     double mapScale = map["scale"];
+    std::vector<glm::ivec2> tileSrcRects;
+    tileSrcRects.reserve(mapNumRows * mapNumCols);
     std::fstream mapFile;
     mapFile.open(mapFilePath);
     for (int y = 0; y < mapNumRows; y++) {
@@ -85,18 +91,32 @@ void LevelLoader::LoadLevel(
             int srcRectX = std::atoi(&ch) * tileSize;
             mapFile.ignore();
 
-            Entity tile = registry->CreateEntity();
-            tile.AddComponent<TransformComponent>(glm::vec2(x * (mapScale * tileSize), y * (mapScale * tileSize)), glm::vec2(mapScale, mapScale), 0.0);
-            tile.AddComponent<SpriteComponent>(mapTextureAssetId, tileSize, tileSize, 0, false, srcRectX, srcRectY);
+            tileSrcRects.push_back(glm::ivec2(srcRectX, srcRectY));
         }
     }
     mapFile.close();
+
+    // Create all the tiles in one block, row by row
+    EntityRange tiles = registry->CreateEntities(static_cast<int>(tileSrcRects.size()));
+    registry->AddComponents<TransformComponent>(tiles, [&](int i) {
+        int x = i % mapNumCols;
+        int y = i / mapNumCols;
+        return TransformComponent(glm::vec2(x * (mapScale * tileSize), y * (mapScale * tileSize)), glm::vec2(mapScale, mapScale), 0.0);
+    });
+    // Every tile points at the same sprite data, only the source rect differs
+    const auto tileSpriteData = Shared<SpriteData>::Make(mapTextureAssetId, tileSize, tileSize, 0, false);
+    registry->AddComponents<SpriteComponent>(tiles, [&](int i) {
+        return SpriteComponent(tileSpriteData, tileSrcRects[i].x, tileSrcRects[i].y);
+    });
     Game::mapWidth = mapNumCols * tileSize * mapScale;
     Game::mapHeight = mapNumRows * tileSize * mapScale;
 
     ////////////////////////////////////////////////////////////////////////////
     // Read the level entities and their components
     ////////////////////////////////////////////////////////////////////////////
+    // Level-wide sleep distances, for the entities that don't set their own
+    sol::optional<sol::table> levelSleep = level["sleep"];
+
     sol::table entities = level["entities"];
     i = 0;
     while (true) {
@@ -246,6 +266,28 @@ void LevelLoader::LoadLevel(
             sol::function func = entity["components"]["on_update_script"][0];
             newEntity.AddComponent<ScriptComponent>(func);
         }
+
+        // Sleep (the level's distances apply to every world-space sprite the camera doesn't follow)
+        sol::optional<sol::table> sleep = entity["components"]["sleep"];
+        if (sleep != sol::nullopt) {
+            newEntity.AddComponent<SleepComponent>(
+                entity["components"]["sleep"]["distance"].get<double>(),
+                entity["components"]["sleep"]["wake_distance"].get_or(entity["components"]["sleep"]["distance"].get<double>())
+            );
+        } else if (
+            levelSleep != sol::nullopt &&
+            newEntity.HasComponent<TransformComponent>() &&
+            newEntity.HasComponent<SpriteComponent>() &&
+            !newEntity.GetComponent<SpriteComponent>().data->isFixed &&
+            !newEntity.HasComponent<CameraFollowComponent>()
+        ) {
+            newEntity.AddComponent<SleepComponent>(
+                level["sleep"]["distance"].get<double>(),
+                level["sleep"]["wake_distance"].get_or(level["sleep"]["distance"].get<double>())
+            );
+        }
         i++;
     }
+
+    jobSystem.WaitAll(textureJobs);
 }
@@ -2,6 +2,7 @@
 
 #include "../ECS/ECS.h"
 #include "../AssetStore/AssetStore.h"
+#include "../Jobs/JobSystem.h"
 #include <SDL2/SDL.h>
 #include <memory>
 #include <sol/sol.hpp>
@@ -16,6 +17,7 @@ class LevelLoader {
             const std::unique_ptr<Registry>& registry,
             const std::unique_ptr<AssetStore>& assetStore,
             SDL_Renderer* renderer,
+            JobSystem& jobSystem,
             int levelNumber
         );
 };
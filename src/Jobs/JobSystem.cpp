@@ -0,0 +1,229 @@
+#include "JobSystem.h"
+#include "../Logger/Logger.h"
+#include <algorithm>
+#include <string>
+
+struct Job {
+    std::function<void()> work;
+    bool isMainThreadOnly = false;
+
+    // Dependencies not done yet, plus one held while the job is being scheduled
+    std::atomic<int> pendingDependencies{1};
+
+    std::mutex mutex;
+    bool isDone = false;
+    std::vector<std::shared_ptr<Job>> continuations;
+};
+
+// Index of the queue owned by the current thread, -1 outside the workers
+static thread_local int currentWorkerIndex = -1;
+
+bool JobHandle::IsDone() const {
+    if (!job) {
+        return true;
+    }
+    std::lock_guard<std::mutex> lock(job->mutex);
+    return job->isDone;
+}
+
+JobSystem::JobSystem(int workerCount): mainThreadId(std::this_thread::get_id()) {
+    workerCount = std::max(0, workerCount);
+    for (int i = 0; i < std::max(1, workerCount); i++) {
+        queues.push_back(std::make_unique<WorkerQueue>());
+    }
+    for (int i = 0; i < workerCount; i++) {
+        workers.emplace_back(&JobSystem::WorkerLoop, this, i);
+    }
+    Logger::Log("Job system created with " + std::to_string(workerCount) + " worker threads.");
+}
+
+JobSystem::~JobSystem() {
+    {
+        std::lock_guard<std::mutex> lock(stateMutex);
+        isStopping = true;
+    }
+    stateChanged.notify_all();
+    for (auto& worker: workers) {
+        worker.join();
+    }
+    Logger::Log("Job system destroyed.");
+}
+
+JobHandle JobSystem::Schedule(std::function<void()> work, const std::vector<JobHandle>& dependencies) {
+    return Schedule(std::move(work), dependencies, false);
+}
+
+JobHandle JobSystem::ScheduleOnMainThread(std::function<void()> work, const std::vector<JobHandle>& dependencies) {
+    return Schedule(std::move(work), dependencies, true);
+}
+
+JobHandle JobSystem::Schedule(std::function<void()> work, const std::vector<JobHandle>& dependencies, bool isMainThreadOnly) {
+    auto job = std::make_shared<Job>();
+    job->work = std::move(work);
+    job->isMainThreadOnly = isMainThreadOnly;
+
+    for (const auto& dependency: dependencies) {
+        if (!dependency.job) {
+            continue;
+        }
+        std::lock_guard<std::mutex> lock(dependency.job->mutex);
+        if (!dependency.job->isDone) {
+            job->pendingDependencies++;
+            dependency.job->continuations.push_back(job);
+        }
+    }
+
+    if (--job->pendingDependencies == 0) {
+        Enqueue(job);
+    }
+    return JobHandle(job);
+}
+
+JobHandle JobSystem::ScheduleParallelFor(int count, int batchSize, std::function<void(int begin, int end)> func, const std::vector<JobHandle>& dependencies) {
+    batchSize = std::max(1, batchSize);
+    auto sharedFunc = std::make_shared<std::function<void(int, int)>>(std::move(func));
+
+    std::vector<JobHandle> batches;
+    for (int begin = 0; begin < count; begin += batchSize) {
+        const int end = std::min(count, begin + batchSize);
+        batches.push_back(Schedule([sharedFunc, begin, end]() { (*sharedFunc)(begin, end); }, dependencies));
+    }
+
+    // (an empty job that completes once every batch has)
+    return Schedule([]() {}, batches);
+}
+
+void JobSystem::ParallelFor(int count, int batchSize, std::function<void(int begin, int end)> func) {
+    Wait(ScheduleParallelFor(count, batchSize, std::move(func)));
+}
+
+void JobSystem::Enqueue(std::shared_ptr<Job> job) {
+    const bool isMainThreadOnly = job->isMainThreadOnly;
+    if (isMainThreadOnly) {
+        std::lock_guard<std::mutex> lock(mainThreadMutex);
+        mainThreadJobs.push_back(std::move(job));
+    } else {
+        // Workers keep the jobs they spawn; other threads spread them round-robin
+        const int queueIndex = currentWorkerIndex != -1 ? currentWorkerIndex : static_cast<int>(nextQueue++ % queues.size());
+        std::lock_guard<std::mutex> lock(queues[queueIndex]->mutex);
+        queues[queueIndex]->jobs.push_back(std::move(job));
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(stateMutex);
+        (isMainThreadOnly ? queuedMainThreadJobs : queuedJobs)++;
+    }
+    stateChanged.notify_all();
+}
+
+std::shared_ptr<Job> JobSystem::TakeJob(int queueIndex) {
+    std::shared_ptr<Job> job;
+
+    // Own queue first, newest job (its data is most likely still in cache)
+    if (queueIndex != -1) {
+        std::lock_guard<std::mutex> lock(queues[queueIndex]->mutex);
+        if (!queues[queueIndex]->jobs.empty()) {
+            job = std::move(queues[queueIndex]->jobs.back());
+            queues[queueIndex]->jobs.pop_back();
+        }
+    }
+
+    // Then steal the oldest job of another queue
+    const int queueCount = static_cast<int>(queues.size());
+    for (int i = 1; !job && i <= queueCount; i++) {
+        const int victim = (std::max(queueIndex, 0) + i) % queueCount;
+        std::lock_guard<std::mutex> lock(queues[victim]->mutex);
+        if (!queues[victim]->jobs.empty()) {
+            job = std::move(queues[victim]->jobs.front());
+            queues[victim]->jobs.pop_front();
+        }
+    }
+
+    if (job) {
+        queuedJobs--;
+    }
+    return job;
+}
+
+bool JobSystem::RunMainThreadJob() {
+    std::shared_ptr<Job> job;
+    {
+        std::lock_guard<std::mutex> lock(mainThreadMutex);
+        if (mainThreadJobs.empty()) {
+            return false;
+        }
+        job = std::move(mainThreadJobs.front());
+        mainThreadJobs.pop_front();
+    }
+    queuedMainThreadJobs--;
+    Run(job);
+    return true;
+}
+
+void JobSystem::Run(const std::shared_ptr<Job>& job) {
+    job->work();
+
+    std::vector<std::shared_ptr<Job>> continuations;
+    {
+        std::lock_guard<std::mutex> lock(job->mutex);
+        job->isDone = true;
+        continuations.swap(job->continuations);
+    }
+    for (auto& continuation: continuations) {
+        if (--continuation->pendingDependencies == 0) {
+            Enqueue(std::move(continuation));
+        }
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(stateMutex);
+    }
+    stateChanged.notify_all();
+}
+
+void JobSystem::Wait(const JobHandle& handle) {
+    const bool isMainThread = std::this_thread::get_id() == mainThreadId;
+    while (!handle.IsDone()) {
+        if (isMainThread && RunMainThreadJob()) {
+            continue;
+        }
+        if (auto job = TakeJob(currentWorkerIndex)) {
+            Run(job);
+            continue;
+        }
+
+        // Nothing to help with: sleep until a job finishes or gets queued
+        std::unique_lock<std::mutex> lock(stateMutex);
+        stateChanged.wait(lock, [&]() {
+            return handle.IsDone() || queuedJobs > 0 || (isMainThread && queuedMainThreadJobs > 0);
+        });
+    }
+}
+
+void JobSystem::WaitAll(const std::vector<JobHandle>& handles) {
+    for (const auto& handle: handles) {
+        Wait(handle);
+    }
+}
+
+void JobSystem::ProcessMainThreadJobs() {
+    while (RunMainThreadJob()) {}
+}
+
+void JobSystem::WorkerLoop(int workerIndex) {
+    currentWorkerIndex = workerIndex;
+    while (true) {
+        if (auto job = TakeJob(workerIndex)) {
+            Run(job);
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(stateMutex);
+        stateChanged.wait(lock, [this]() {
+            return isStopping || queuedJobs > 0;
+        });
+        if (isStopping) {
+            return;
+        }
+    }
+}
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <vector>
+#include <deque>
+#include <memory>
+#include <functional>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+
+struct Job;
+
+// Reference to a scheduled job, used to wait on it or to make other jobs depend on it
+class JobHandle {
+    private:
+        std::shared_ptr<Job> job;
+
+        friend class JobSystem;
+
+    public:
+        JobHandle() = default;
+        JobHandle(std::shared_ptr<Job> job): job(std::move(job)) {}
+
+        bool IsValid() const {
+            return job != nullptr;
+        }
+        bool IsDone() const;
+};
+
+// Work-stealing job system. Every worker owns a deque: it pushes and pops its own jobs at the back
+// while idle workers steal from the front of the others. Jobs only become runnable once all their
+// dependencies are done. Jobs with main thread affinity (anything touching SDL) are queued
+// separately and run by ProcessMainThreadJobs() or while the main thread waits.
+// With no worker threads nothing runs concurrently: jobs run in FIFO order on whoever waits.
+class JobSystem {
+    private:
+        struct WorkerQueue {
+            std::mutex mutex;
+            std::deque<std::shared_ptr<Job>> jobs;
+        };
+
+        std::vector<std::unique_ptr<WorkerQueue>> queues;
+        std::vector<std::thread> workers;
+        std::thread::id mainThreadId;
+        std::atomic<unsigned int> nextQueue{0};
+
+        std::mutex mainThreadMutex;
+        std::deque<std::shared_ptr<Job>> mainThreadJobs;
+
+        // Sleeping workers and waiting threads are woken whenever a job is queued or finishes
+        std::mutex stateMutex;
+        std::condition_variable stateChanged;
+        std::atomic<int> queuedJobs{0};
+        std::atomic<int> queuedMainThreadJobs{0};
+        bool isStopping = false;
+
+        JobHandle Schedule(std::function<void()> work, const std::vector<JobHandle>& dependencies, bool isMainThreadOnly);
+        void Enqueue(std::shared_ptr<Job> job);
+        std::shared_ptr<Job> TakeJob(int queueIndex);
+        bool RunMainThreadJob();
+        void Run(const std::shared_ptr<Job>& job);
+        void WorkerLoop(int workerIndex);
+
+    public:
+        // Created on the main thread; zero workers gives the single-threaded mode
+        JobSystem(int workerCount);
+        ~JobSystem();
+
+        JobSystem(const JobSystem&) = delete;
+        JobSystem& operator=(const JobSystem&) = delete;
+
+        int GetWorkerCount() const {
+            return static_cast<int>(workers.size());
+        }
+
+        // Runs work once every dependency is done (continuations are jobs depending on the one before)
+        JobHandle Schedule(std::function<void()> work, const std::vector<JobHandle>& dependencies = {});
+        JobHandle ScheduleOnMainThread(std::function<void()> work, const std::vector<JobHandle>& dependencies = {});
+
+        // Splits [0, count) into batches of batchSize and runs func(begin, end) for each of them
+        JobHandle ScheduleParallelFor(int count, int batchSize, std::function<void(int begin, int end)> func, const std::vector<JobHandle>& dependencies = {});
+        void ParallelFor(int count, int batchSize, std::function<void(int begin, int end)> func);
+
+        // Runs queued jobs on the calling thread until the job is done
+        void Wait(const JobHandle& handle);
+        void WaitAll(const std::vector<JobHandle>& handles);
+
+        // Called by the main thread once per frame
+        void ProcessMainThreadJobs();
+};
@@ -3,6 +3,7 @@
 #include <chrono>
 #include <ctime>
 #include <vector>
+#include <mutex>
 
 std::string CurrentDateTimeToString()
 {
@@ -14,8 +15,12 @@ std::string CurrentDateTimeToString()
 
 std::vector<LogEntry> Logger::messages;
 
+// Systems may log from worker threads
+static std::mutex logMutex;
+
 void Logger::Log(const std::string &message)
 {
+    std::lock_guard<std::mutex> lock(logMutex);
     LogEntry logEntry;
     logEntry.type = LogType::LOG_INFO;
     logEntry.message = "LOG: [" + CurrentDateTimeToString() + "]: " + message;
@@ -25,6 +30,7 @@ void Logger::Log(const std::string &message)
 
 void Logger::Err(const std::string &message)
 {
+    std::lock_guard<std::mutex> lock(logMutex);
     LogEntry logEntry;
     logEntry.type = LogType::LOG_ERROR;
     logEntry.message = "ERR: [" + CurrentDateTimeToString() + "]: " + message;
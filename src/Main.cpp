@@ -1,9 +1,29 @@
 #include <iostream>
+#include <string>
+#include <thread>
+#include <algorithm>
+#include <cstdlib>
 #include "./Game/Game.h"
+#include "./EventBus/EventBusBenchmark.h"
 
 int main(int argc, char *argv[])
 {
-    Game game;
+    StorageMode storageMode = StorageMode::SparseSet;
+    int workerCount = std::max(0, static_cast<int>(std::thread::hardware_concurrency()) - 1);
+    for (int i = 1; i < argc; i++) {
+        if (std::string(argv[i]) == "--archetype-storage") {
+            storageMode = StorageMode::Archetype;
+        }
+        if (std::string(argv[i]) == "--worker-threads" && i + 1 < argc) {
+            workerCount = std::max(0, std::atoi(argv[++i]));
+        }
+        if (std::string(argv[i]) == "--benchmark-events") {
+            EventBusBenchmark::Run();
+            return 0;
+        }
+    }
+
+    Game game(storageMode, workerCount);
 
     game.Initialize();
     game.Run();
@@ -9,16 +9,14 @@ class AnimationSystem: public System {
         AnimationSystem() {
             RequireComponent<SpriteComponent>();
             RequireComponent<AnimationComponent>();
+            WritesComponent<SpriteComponent>();
+            WritesComponent<AnimationComponent>();
         }
 
-        void Update() {
-            for (auto entity : GetEntities())
-            {
-                auto& sprite = entity.GetComponent<SpriteComponent>();
-                auto& animation = entity.GetComponent<AnimationComponent>();
-
+        void Update(const std::unique_ptr<Registry>& registry, JobSystem& jobSystem) {
+            registry->View<SpriteComponent, AnimationComponent>().ParallelEach(jobSystem, DEFAULT_PARALLEL_CHUNK_SIZE, [](Entity entity, SpriteComponent& sprite, AnimationComponent& animation) {
                 animation.currentFrame = ((SDL_GetTicks() - animation.startTime) * animation.frameSpeedRate / 1000) % animation.numFrames;
-                sprite.srcRect.x = animation.currentFrame * sprite.width;
-            }
+                sprite.srcRect.x = animation.currentFrame * sprite.data->width;
+            });
         }
 };
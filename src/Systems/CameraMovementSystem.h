@@ -12,10 +12,8 @@ class CameraMovementSystem: public System {
             RequireComponent<TransformComponent>();
         }
 
-        void Update(SDL_Rect& camera) {
-            for(auto entity: GetEntities()) {
-                auto transform = entity.GetComponent<TransformComponent>();
-
+        void Update(const std::unique_ptr<Registry>& registry, SDL_Rect& camera) {
+            registry->View<const CameraFollowComponent, const TransformComponent>().Each([&camera](Entity entity, const CameraFollowComponent&, const TransformComponent& transform) {
                 if(transform.position.x + (camera.w / 2) < Game::mapWidth) {
                     camera.x = transform.position.x  - (Game::windowWidth / 2);
                 }
@@ -28,6 +26,6 @@ class CameraMovementSystem: public System {
                 camera.y = camera.y < 0 ? 0 : camera.y;
                 camera.x = camera.x > camera.w ? camera.w : camera.x;
                 camera.y = camera.y > camera.h ? camera.h : camera.y;
-            }
+            });
         }
 };
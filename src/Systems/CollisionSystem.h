@@ -2,53 +2,96 @@
 
 #include "../ECS/ECS.h"
 #include "../EventBus/EventBus.h"
+#include "../Jobs/JobSystem.h"
 #include "../Events/CollisionEvent.h"
+#include "../Events/CollisionLayers.h"
 #include "../Components/BoxColliderComponent.h"
 #include "../Components/TransformComponent.h"
 
 class CollisionSystem: public System {
+    private:
+        struct Collidable {
+            Entity entity;
+            double x;
+            double y;
+            double width;
+            double height;
+            int layer;
+        };
+
+        // Reused every frame so the broad phase doesn't allocate once it has warmed up
+        std::vector<Collidable> collidables;
+
+        // Rows of the pair test handed to each job (the early rows test the most pairs)
+        static constexpr int PAIR_ROWS_PER_JOB = 32;
+
     public:
         CollisionSystem() {
             RequireComponent<TransformComponent>();
             RequireComponent<BoxColliderComponent>();
         }
 
-        void Update(std::unique_ptr<EventBus>& eventBus) {
-            auto entities = GetEntities();
+        // Only queues the collisions: the handlers, which modify and kill the colliding entities,
+        // get them all at once when the game dispatches the queued events after the scheduler
+        void Update(const std::unique_ptr<Registry>& registry, std::unique_ptr<EventBus>& eventBus, JobSystem& jobSystem) {
+            collidables.clear();
+            registry->View<const TransformComponent, const BoxColliderComponent>().Each([this, &registry](Entity entity, const TransformComponent& transform, const BoxColliderComponent& collider) {
+                collidables.push_back({
+                    entity,
+                    transform.position.x + collider.offset.x,
+                    transform.position.y + collider.offset.y,
+                    static_cast<double>(collider.width),
+                    static_cast<double>(collider.height),
+                    CollisionLayers::GetEntityLayer(*registry, entity)
+                });
+            });
 
-           for (auto i = entities.begin(); i!= entities.end(); i++) {
-               Entity a = *i;
+           // Every job queues its own collisions (the bus keeps a buffer per thread and sorts them at dispatch)
+           EventBus& bus = *eventBus;
+           const bool hasUnroutedSubscribers = bus.HasSubscribers<CollisionEvent>();
+           jobSystem.ParallelFor(static_cast<int>(collidables.size()), PAIR_ROWS_PER_JOB, [this, &bus, hasUnroutedSubscribers](int begin, int end) {
+               for (size_t i = begin; i < static_cast<size_t>(end); i++) {
+                   const Collidable& a = collidables[i];
 
-               auto aTransform = a.GetComponent<TransformComponent>();
-               auto aCollider = a.GetComponent<BoxColliderComponent>();
-
-               for(auto j = i; j != entities.end(); j++) {
-                   Entity b = *j;
-
-                   if(a == b) {
-                       continue;
-                   }
+                   for(size_t j = i + 1; j < collidables.size(); j++) {
+                       const Collidable& b = collidables[j];
 
-                   auto bTransform = b.GetComponent<TransformComponent>();
-                   auto bCollider = b.GetComponent<BoxColliderComponent>();
+                       // Each layer pair routes to the subscribers of that pair, in both orders
+                       int channel = CollisionLayers::NO_CHANNEL;
+                       int reversedChannel = CollisionLayers::NO_CHANNEL;
+                       if (a.layer != CollisionLayers::NO_LAYER && b.layer != CollisionLayers::NO_LAYER) {
+                           channel = CollisionLayers::GetPairChannel(a.layer, b.layer);
+                           reversedChannel = a.layer != b.layer ? CollisionLayers::GetPairChannel(b.layer, a.layer) : CollisionLayers::NO_CHANNEL;
+                       }
+                       if (!hasUnroutedSubscribers && channel == CollisionLayers::NO_CHANNEL && reversedChannel == CollisionLayers::NO_CHANNEL) {
+                           continue;
+                       }
 
-                  bool collisionHappened = CheckAABBCollision(
-                       aTransform.position.x + aCollider.offset.x,
-                       aTransform.position.y + aCollider.offset.y,
-                       aCollider.width,
-                       aCollider.height,
-                       bTransform.position.x + bCollider.offset.x,
-                       bTransform.position.y + bCollider.offset.y,
-                       bCollider.width,
-                       bCollider.height
-                   );
+                      bool collisionHappened = CheckAABBCollision(
+                           a.x,
+                           a.y,
+                           a.width,
+                           a.height,
+                           b.x,
+                           b.y,
+                           b.width,
+                           b.height
+                       );
 
-                   if(collisionHappened) {
-                       Logger::Log("Entity " + std::to_string(a.GetId()) + " is collidingwith entity " + std::to_string(b.GetId()) + ".");
-                       eventBus->EmitEvent<CollisionEvent>(a, b);
+                       if(collisionHappened) {
+                           if (hasUnroutedSubscribers) {
+                               bus.QueueEvent<CollisionEvent>(a.entity, b.entity);
+                           }
+                           if (channel != CollisionLayers::NO_CHANNEL) {
+                               bus.QueueEventOnChannel<CollisionEvent>(channel, a.entity, b.entity);
+                           }
+                           if (reversedChannel != CollisionLayers::NO_CHANNEL) {
+                               bus.QueueEventOnChannel<CollisionEvent>(reversedChannel, b.entity, a.entity);
+                           }
+                       }
                    }
                }
-           }
+           });
         }
 
         bool CheckAABBCollision(
@@ -6,6 +6,7 @@
 #include "../Components/HealthComponent.h"
 #include "../EventBus/EventBus.h"
 #include "../Events/CollisionEvent.h"
+#include "../Events/CollisionLayers.h"
 
 class DamageSystem: public System {
     public:
@@ -14,28 +15,23 @@ class DamageSystem: public System {
         }
 
         void SubscribeToEvents(std::unique_ptr<EventBus>& eventBus) {
-            eventBus->SubscribeToEvent<CollisionEvent>(this, &DamageSystem::OnCollision);
+            eventBus->SubscribeToEvents<CollisionEvent>(CollisionLayers::GetPairChannel("projectiles", "player"), this, &DamageSystem::OnProjectilesHitPlayer);
+            eventBus->SubscribeToEvents<CollisionEvent>(CollisionLayers::GetPairChannel("projectiles", "enemies"), this, &DamageSystem::OnProjectilesHitEnemies);
         }
 
-        void OnCollision(CollisionEvent& event) {
-            Entity a = event.a;
-            Entity b = event.b;
-            Logger::Log("Damage system recieved collision event between " + std::to_string(a.GetId()) + " and " + std::to_string(b.GetId()) + ".");
-
-            if(a.BelongsToGroup("projectiles") && b.HasTag("player")) {
-                OnProjectileHitsPlayer(a, b);
-            }
-
-            if(b.BelongsToGroup("projectiles") && a.HasTag("player")) {
-                OnProjectileHitsPlayer(b, a);
-            }
-
-            if(a.BelongsToGroup("projectiles") && b.BelongsToGroup("enemies")) {
-                OnProjectileHitsEnemy(a, b);
+        // (a is the projectile, b the player)
+        void OnProjectilesHitPlayer(EventSpan<CollisionEvent> events) {
+            for (auto& event: events) {
+                Logger::Log("Damage system recieved collision event between " + std::to_string(event.a.GetId()) + " and " + std::to_string(event.b.GetId()) + ".");
+                OnProjectileHitsPlayer(event.a, event.b);
             }
+        }
 
-            if(b.BelongsToGroup("projectiles") && a.BelongsToGroup("enemies")) {
-                OnProjectileHitsEnemy(b, a);
+        // (a is the projectile, b the enemy)
+        void OnProjectilesHitEnemies(EventSpan<CollisionEvent> events) {
+            for (auto& event: events) {
+                Logger::Log("Damage system recieved collision event between " + std::to_string(event.a.GetId()) + " and " + std::to_string(event.b.GetId()) + ".");
+                OnProjectileHitsEnemy(event.a, event.b);
             }
         }
 
@@ -46,6 +42,7 @@ class DamageSystem: public System {
                 auto& health = player.GetComponent<HealthComponent>();
 
                 health.healthPercentage -= projectileComponent.hitPercentDamage;
+                player.MarkChanged<HealthComponent>();
 
                 if(health.healthPercentage <= 0) {
                     player.Kill();
@@ -62,6 +59,7 @@ class DamageSystem: public System {
                 auto& health = enemy.GetComponent<HealthComponent>();
 
                 health.healthPercentage -= projectileComponent.hitPercentDamage;
+                enemy.MarkChanged<HealthComponent>();
 
                 if(health.healthPercentage <= 0) {
                     enemy.Kill();
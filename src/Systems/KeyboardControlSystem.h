@@ -19,7 +19,7 @@ class KeyboardControlSystem: public System {
             eventBus->SubscribeToEvent<KeyPressedEvent>(this, &KeyboardControlSystem::OnKeyPressed);
         }
 
-        void OnKeyPressed(KeyPressedEvent& event) {
+        void OnKeyPressed(const KeyPressedEvent& event) {
             for(auto entity: GetEntities()) {
                 const auto keyboardControl = entity.GetComponent<KeyboardControlledComponent>();
                 auto& sprite = entity.GetComponent<SpriteComponent>();
@@ -28,22 +28,24 @@ class KeyboardControlSystem: public System {
                 switch (event.symbol) {
                     case SDLK_UP:
                         rigidBody.velocity = keyboardControl.upVelocity;
-                        sprite.srcRect.y = sprite.height * 0;
+                        sprite.srcRect.y = sprite.data->height * 0;
                         break;
                     case SDLK_RIGHT:
                         rigidBody.velocity = keyboardControl.rightVelocity;
-                        sprite.srcRect.y = sprite.height * 1;
+                        sprite.srcRect.y = sprite.data->height * 1;
                         break;
                     case SDLK_DOWN:
                         rigidBody.velocity = keyboardControl.downVelocity;
-                        sprite.srcRect.y = sprite.height * 2;
+                        sprite.srcRect.y = sprite.data->height * 2;
                         break;
                     case SDLK_LEFT:
                         rigidBody.velocity = keyboardControl.leftVelocity;
-                        sprite.srcRect.y = sprite.height * 3;
+                        sprite.srcRect.y = sprite.data->height * 3;
                         break;
                 }
 
+                entity.MarkChanged<RigidBodyComponent>();
+                entity.MarkChanged<SpriteComponent>();
             }
         }
 
@@ -6,29 +6,28 @@
 #include "../Components/SpriteComponent.h"
 #include "../EventBus/EventBus.h"
 #include "../Events/CollisionEvent.h"
+#include "../Events/CollisionLayers.h"
 
 class MovementSystem: public System {
+    private:
+        int playerTag = Registry::GetTagId("player");
+
     public:
         MovementSystem() {
             RequireComponent<TransformComponent>();
             RequireComponent<RigidBodyComponent>();
+            WritesComponent<TransformComponent>();
         }
 
         void SubscribeToEvents(const std::unique_ptr<EventBus>& eventBus) {
-            eventBus->SubscribeToEvent<CollisionEvent>(this, &MovementSystem::OnCollision);
+            eventBus->SubscribeToEvents<CollisionEvent>(CollisionLayers::GetPairChannel("enemies", "obstacles"), this, &MovementSystem::OnEnemiesHitObstacles);
         }
 
-        void OnCollision(CollisionEvent& event) {
-            Entity a = event.a;
-            Entity b = event.b;
-            Logger::Log("Movement system recieved collision event between " + std::to_string(a.GetId()) + " and " + std::to_string(b.GetId()) + ".");
-
-            if(a.BelongsToGroup("enemies") && b.BelongsToGroup("obstacles")) {
-                OnEnemyHitsObstacle(a, b);
-            }
-
-            if(a.BelongsToGroup("obstacles") && b.BelongsToGroup("enemies")) {
-                OnEnemyHitsObstacle(b, a);
+        // (a is the enemy, b the obstacle)
+        void OnEnemiesHitObstacles(EventSpan<CollisionEvent> events) {
+            for (auto& event: events) {
+                Logger::Log("Movement system recieved collision event between " + std::to_string(event.a.GetId()) + " and " + std::to_string(event.b.GetId()) + ".");
+                OnEnemyHitsObstacle(event.a, event.b);
             }
         }
 
@@ -46,19 +45,20 @@ class MovementSystem: public System {
                     rigidbody.velocity.y *= -1;
                     sprite.flip = (sprite.flip == SDL_FLIP_NONE ? SDL_FLIP_VERTICAL : SDL_FLIP_NONE);
                 }
+
+                if(rigidbody.velocity.x != 0 || rigidbody.velocity.y != 0) {
+                    enemy.MarkChanged<RigidBodyComponent>();
+                    enemy.MarkChanged<SpriteComponent>();
+                }
             }
         }
 
-        void Update(double deltaTime) {
-            for (auto entity : GetEntities())
-            {
-                auto& transform = entity.GetComponent<TransformComponent>();
-                const auto rigidbody = entity.GetComponent<RigidBodyComponent>();
-
+        void Update(const std::unique_ptr<Registry>& registry, JobSystem& jobSystem, double deltaTime) {
+            registry->View<TransformComponent, const RigidBodyComponent>().ParallelEach(jobSystem, DEFAULT_PARALLEL_CHUNK_SIZE, [this, deltaTime](Entity entity, TransformComponent& transform, const RigidBodyComponent& rigidbody) {
                 transform.position.x += rigidbody.velocity.x * deltaTime;
                 transform.position.y += rigidbody.velocity.y * deltaTime;
 
-                if(entity.HasTag("player")) {
+                if(entity.HasTag(playerTag)) {
                     int paddingLeft = 10;
                     int paddingTop = 10;
                     int paddingRight = 50;
@@ -78,9 +78,9 @@ class MovementSystem: public System {
                     transform.position.y > Game::mapHeight + cullingMargin
                 );
 
-                if(isEntityOutsideMap && !entity.HasTag("player")) {
+                if(isEntityOutsideMap && !entity.HasTag(playerTag)) {
                     entity.Kill();
                 }
-            }
+            });
         }
 };
@@ -9,85 +9,94 @@
 #include "../Components/BoxColliderComponent.h"
 #include "../Components/RigidBodyComponent.h"
 #include "../Components/ProjectileComponent.h"
+#include "../Components/CameraFollowComponent.h"
 #include <SDL2/SDL.h>
 
 class ProjectileEmitSystem: public System {
+    private:
+        Prefab projectilePrefab;
+
+        // Emitters that fire on key press: the ones the camera follows
+        using PlayerEmitterQuery = Query<
+            With<ProjectileEmitterComponent, TransformComponent, RigidBodyComponent, CameraFollowComponent>,
+            Without<>,
+            Optional<SpriteComponent>
+        >;
+
+        void SpawnProjectile(Registry& registry, glm::vec2 position, glm::vec2 velocity, const ProjectileEmitterComponent& projectileEmitter) {
+            Entity projectile = registry.Instantiate(projectilePrefab);
+            registry.GetComponent<TransformComponent>(projectile).position = position;
+            registry.GetComponent<RigidBodyComponent>(projectile).velocity = velocity;
+            // (also restarts the lifetime clock, which the prefab's copy froze at creation time)
+            registry.GetComponent<ProjectileComponent>(projectile) = ProjectileComponent(projectileEmitter.isFriendly, projectileEmitter.hitPercentDamage, projectileEmitter.duration);
+        }
+
     public:
         ProjectileEmitSystem() {
             RequireComponent<TransformComponent>();
             RequireComponent<ProjectileEmitterComponent>();
+            RequireExclusiveAccess();
+
+            projectilePrefab.Group("projectiles");
+            projectilePrefab.AddComponent<TransformComponent>(glm::vec2(0.0, 0.0), glm::vec2(1.0, 1.0), 0.0);
+            projectilePrefab.AddComponent<RigidBodyComponent>();
+            projectilePrefab.AddComponent<SpriteComponent>("bullet-texture", 4, 4, 4);
+            projectilePrefab.AddComponent<BoxColliderComponent>(4, 4);
+            projectilePrefab.AddComponent<ProjectileComponent>();
         }
 
         void SubscribeToEvents(std::unique_ptr<EventBus>& eventBus) {
             eventBus->SubscribeToEvent<KeyPressedEvent>(this, &ProjectileEmitSystem::OnKeyPressed);
         }
 
-        void OnKeyPressed(KeyPressedEvent& event) {
+        void OnKeyPressed(const KeyPressedEvent& event) {
             if(event.symbol == SDLK_SPACE) {
                    Logger::Log("SPACE PRESSED");
-                   for (auto entity: GetEntities()) {
-                       if(entity.HasComponent<CameraFollowComponent>()) {
-                            const auto projectileEmitter = entity.GetComponent<ProjectileEmitterComponent>();
-                            const auto transform = entity.GetComponent<TransformComponent>();
-                            const auto rigidbody = entity.GetComponent<RigidBodyComponent>();
-
-                            glm::vec2 projectilePosition = transform.position;
-                            if(entity.HasComponent<SpriteComponent>()) {
-                                auto sprite = entity.GetComponent<SpriteComponent>();
-                                projectilePosition.x += (transform.scale.x * sprite.width / 2);
-                                projectilePosition.y += (transform.scale.y * sprite.height / 2);
-                            }
+                   Registry& registry = *Registry::GetCurrent();
+                   registry.GetQuery<PlayerEmitterQuery>().Each([this, &registry](Entity entity, const ProjectileEmitterComponent& projectileEmitter, const TransformComponent& transform, const RigidBodyComponent& rigidbody, const CameraFollowComponent&, const SpriteComponent* sprite) {
+                        glm::vec2 projectilePosition = transform.position;
+                        if(sprite) {
+                            projectilePosition.x += (transform.scale.x * sprite->data->width / 2);
+                            projectilePosition.y += (transform.scale.y * sprite->data->height / 2);
+                        }
 
-                            glm::vec2 projectileVelocity = projectileEmitter.velocity;
-                            int directionX = 0;
-                            int directionY = 0;
-                            if(rigidbody.velocity.x > 0) directionX = +1;
-                            if(rigidbody.velocity.x < 0) directionX = -1;
-                            if(rigidbody.velocity.y > 0) directionY = +1;
-                            if(rigidbody.velocity.y < 0) directionY = -1;
-                            projectileVelocity.x = projectileEmitter.velocity.x * directionX;
-                            projectileVelocity.y = projectileEmitter.velocity.y * directionY;
+                        glm::vec2 projectileVelocity = projectileEmitter.velocity;
+                        int directionX = 0;
+                        int directionY = 0;
+                        if(rigidbody.velocity.x > 0) directionX = +1;
+                        if(rigidbody.velocity.x < 0) directionX = -1;
+                        if(rigidbody.velocity.y > 0) directionY = +1;
+                        if(rigidbody.velocity.y < 0) directionY = -1;
+                        projectileVelocity.x = projectileEmitter.velocity.x * directionX;
+                        projectileVelocity.y = projectileEmitter.velocity.y * directionY;
 
-                            Entity projectile = entity.registry->CreateEntity();
-                            projectile.Group("projectiles");
-                            projectile.AddComponent<TransformComponent>(projectilePosition, glm::vec2(1.0, 1.0), 0.0);
-                            projectile.AddComponent<RigidBodyComponent>(projectileVelocity);
-                            projectile.AddComponent<SpriteComponent>("bullet-texture", 4, 4, 4);
-                            projectile.AddComponent<BoxColliderComponent>(4, 4);
-                            projectile.AddComponent<ProjectileComponent>(projectileEmitter.isFriendly, projectileEmitter.hitPercentDamage, projectileEmitter.duration);
-                       }
-                   }
+                        SpawnProjectile(registry, projectilePosition, projectileVelocity, projectileEmitter);
+                   });
             }
 
         }
 
         void Update(std::unique_ptr<Registry>& registry) {
-           for(auto entity: GetEntities()) {
-                const auto transform = entity.GetComponent<TransformComponent>();
-                auto& projectileEmitter = entity.GetComponent<ProjectileEmitterComponent>();
-
+           // Sleeping emitters aren't in the view, so enemies away from the camera hold their fire.
+           // Spawning adds components while the view is iterating: the emitter pool doesn't grow,
+           // but the transform pool may, so the transform reference is only read before spawning.
+           registry->View<const TransformComponent, ProjectileEmitterComponent>().Each([this, &registry](Entity entity, const TransformComponent& transform, ProjectileEmitterComponent& projectileEmitter) {
                 if(projectileEmitter.repeatFrequency == 0) {
-                    continue;
+                    return;
                 }
 
                if(SDL_GetTicks() - projectileEmitter.lastEmissionTime > projectileEmitter.repeatFrequency) {
                    glm::vec2 projectilePosition = transform.position;
                    if(entity.HasComponent<SpriteComponent>()) {
                         const auto sprite = entity.GetComponent<SpriteComponent>();
-                        projectilePosition.x += (transform.scale.x * sprite.width / 2);
-                        projectilePosition.y += (transform.scale.y * sprite.height / 2);
+                        projectilePosition.x += (transform.scale.x * sprite.data->width / 2);
+                        projectilePosition.y += (transform.scale.y * sprite.data->height / 2);
                    }
 
-                   Entity projectile = registry->CreateEntity();
-                   projectile.Group("projectiles");
-                   projectile.AddComponent<TransformComponent>(projectilePosition, glm::vec2(1.0, 1.0), 0.0);
-                   projectile.AddComponent<RigidBodyComponent>(projectileEmitter.velocity);
-                   projectile.AddComponent<SpriteComponent>("bullet-texture", 4, 4, 4);
-                   projectile.AddComponent<BoxColliderComponent>(4, 4);
-                   projectile.AddComponent<ProjectileComponent>(projectileEmitter.isFriendly, projectileEmitter.hitPercentDamage, projectileEmitter.duration);
+                   SpawnProjectile(*registry, projectilePosition, projectileEmitter.velocity, projectileEmitter);
 
                    projectileEmitter.lastEmissionTime = SDL_GetTicks();
                }
-           }
+           });
         }
 };
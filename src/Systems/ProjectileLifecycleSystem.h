@@ -10,13 +10,11 @@ class ProjectileLifecycleSystem: public System {
             RequireComponent<ProjectileComponent>();
         }
 
-        void Update() {
-           for(auto entity: GetEntities()) {
-                const auto projectile = entity.GetComponent<ProjectileComponent>();
-
+        void Update(const std::unique_ptr<Registry>& registry, JobSystem& jobSystem) {
+            registry->View<const ProjectileComponent>().ParallelEach(jobSystem, DEFAULT_PARALLEL_CHUNK_SIZE, [](Entity entity, const ProjectileComponent& projectile) {
                 if(SDL_GetTicks() - projectile.startTime > projectile.duration) {
                     entity.Kill();
                 }
-           }
+            });
         }
 };
@@ -12,11 +12,8 @@ class RenderColliderSystem: public System {
             RequireComponent<BoxColliderComponent>();
         }
 
-        void Update(SDL_Renderer* renderer, SDL_Rect& camera) {
-           for(auto entity: GetEntities()) {
-               const auto transform = entity.GetComponent<TransformComponent>();
-               const auto collider = entity.GetComponent<BoxColliderComponent>();
-
+        void Update(const std::unique_ptr<Registry>& registry, SDL_Renderer* renderer, SDL_Rect& camera) {
+           registry->View<const TransformComponent, const BoxColliderComponent>().Each([renderer, &camera](Entity entity, const TransformComponent& transform, const BoxColliderComponent& collider) {
                SDL_Rect colliderRect = {
                    static_cast<int>(transform.position.x + collider.offset.x - camera.x),
                    static_cast<int>(transform.position.y + collider.offset.y - camera.y),
@@ -26,6 +23,6 @@ class RenderColliderSystem: public System {
 
                SDL_SetRenderDrawColor(renderer, 255, 0, 0, 255);
                SDL_RenderDrawRect(renderer, &colliderRect);
-           }
+           });
         }
 };
@@ -15,11 +15,8 @@ class RenderHealthBarSystem: public System {
             RequireComponent<HealthComponent>();
         }
 
-        void Update(SDL_Renderer* renderer, const std::unique_ptr<AssetStore>& assetStore, const SDL_Rect& camera) {
-            for (auto entity: GetEntities()) {
-                const auto transform = entity.GetComponent<TransformComponent>();
-                const auto sprite = entity.GetComponent<SpriteComponent>();
-                const auto health = entity.GetComponent<HealthComponent>();
+        void Update(const std::unique_ptr<Registry>& registry, SDL_Renderer* renderer, const std::unique_ptr<AssetStore>& assetStore, const SDL_Rect& camera) {
+            registry->View<const TransformComponent, const SpriteComponent, const HealthComponent>().Each([&](Entity entity, const TransformComponent& transform, const SpriteComponent& sprite, const HealthComponent& health) {
 
                 SDL_Color healthBarColor = {255, 255, 255};
 
@@ -35,7 +32,7 @@ class RenderHealthBarSystem: public System {
 
                 int healthBarWidth = 15;
                 int healthBarHeight = 3;
-                double healthBarPosX = (transform.position.x + (sprite.width * transform.scale.x)) - camera.x;
+                double healthBarPosX = (transform.position.x + (sprite.data->width * transform.scale.x)) - camera.x;
                 double healthBarPosY = (transform.position.y) - camera.y;
 
                 SDL_Rect healthBarRectangle = {
@@ -65,6 +62,6 @@ class RenderHealthBarSystem: public System {
                 SDL_RenderCopy(renderer, texture, NULL, &healthBarTextRectangle);
 
                 SDL_DestroyTexture(texture);
-            }
+            });
         }
 };
@@ -10,6 +10,55 @@
 
 class RenderSystem : public System
 {
+private:
+    struct DrawItem {
+        Entity entity;
+        int zIndex;
+    };
+
+    // Draw order, sorted by zIndex, with each sprite's zIndex cached next to its entity. Rebuilt
+    // when entities gain or lose a transform or sprite. Otherwise only the sprites changed since the
+    // last frame have their zIndex re-read, and only when some sprite changed at all.
+    std::vector<DrawItem> drawOrder;
+    uint32_t transformStructureVersion = 0;
+    uint32_t spriteStructureVersion = 0;
+    uint32_t spriteVersion = 0;
+    uint32_t lastChangeTick = 0;
+
+    void UpdateDrawOrder(const std::unique_ptr<Registry>& registry)
+    {
+        const uint32_t sinceTick = lastChangeTick;
+        lastChangeTick = registry->AdvanceChangeTick();
+
+        const uint32_t currentTransformStructureVersion = registry->GetComponentStructureVersion<TransformComponent>();
+        const uint32_t currentSpriteStructureVersion = registry->GetComponentStructureVersion<SpriteComponent>();
+        const uint32_t currentSpriteVersion = registry->GetComponentVersion<SpriteComponent>();
+        if (drawOrder.empty() || currentTransformStructureVersion != transformStructureVersion || currentSpriteStructureVersion != spriteStructureVersion) {
+            drawOrder.clear();
+            registry->View<const TransformComponent, const SpriteComponent>().Each([this](Entity entity, const TransformComponent&, const SpriteComponent& sprite) {
+                drawOrder.push_back({entity, sprite.data->zIndex});
+            });
+            transformStructureVersion = currentTransformStructureVersion;
+            spriteStructureVersion = currentSpriteStructureVersion;
+        } else if (currentSpriteVersion != spriteVersion) {
+            for (auto& item: drawOrder) {
+                if (registry->HasChanged<SpriteComponent>(item.entity, sinceTick)) {
+                    item.zIndex = registry->GetComponent<SpriteComponent>(item.entity).data->zIndex;
+                }
+            }
+        } else {
+            return;
+        }
+        spriteVersion = currentSpriteVersion;
+
+        const auto byZIndex = [](const DrawItem& a, const DrawItem& b) {
+            return a.zIndex < b.zIndex;
+        };
+        if (!std::is_sorted(drawOrder.begin(), drawOrder.end(), byZIndex)) {
+            std::stable_sort(drawOrder.begin(), drawOrder.end(), byZIndex);
+        }
+    }
+
 public:
     RenderSystem()
     {
@@ -17,53 +66,38 @@ public:
         RequireComponent<SpriteComponent>();
     }
 
-    void Update(SDL_Renderer *renderer, std::unique_ptr<AssetStore> &assetStore, SDL_Rect& camera)
+    void Update(const std::unique_ptr<Registry>& registry, SDL_Renderer *renderer, std::unique_ptr<AssetStore> &assetStore, SDL_Rect& camera)
     {
-        struct RenderableEntity {
-            TransformComponent transform;
-            SpriteComponent sprite;
-        };
+        UpdateDrawOrder(registry);
 
-        std::vector<RenderableEntity> renderableEntities;
-        for (auto entity: GetEntities()) {
-            RenderableEntity renderableEntity;
-            renderableEntity.sprite = entity.GetComponent<SpriteComponent>();
-            renderableEntity.transform = entity.GetComponent<TransformComponent>();
+        for (const auto& item : drawOrder)
+        {
+            const Entity entity = item.entity;
+            const auto& transform = registry->GetComponent<TransformComponent>(entity);
+            const auto& sprite = registry->GetComponent<SpriteComponent>(entity);
 
             bool isEntityOutsideCameraView = (
-                renderableEntity.transform.position.x + (renderableEntity.transform.scale.x * renderableEntity.sprite.width) < camera.x ||
-                renderableEntity.transform.position.x > camera.x + camera.w ||
-                renderableEntity.transform.position.y + (renderableEntity.transform.scale.y * renderableEntity.sprite.height) < camera.y ||
-                renderableEntity.transform.position.y > camera.y + camera.h
+                transform.position.x + (transform.scale.x * sprite.data->width) < camera.x ||
+                transform.position.x > camera.x + camera.w ||
+                transform.position.y + (transform.scale.y * sprite.data->height) < camera.y ||
+                transform.position.y > camera.y + camera.h
             );
 
-            if(isEntityOutsideCameraView && !renderableEntity.sprite.isFixed) {
+            if(isEntityOutsideCameraView && !sprite.data->isFixed) {
                 continue;
             }
 
-            renderableEntities.emplace_back(renderableEntity);
-        }
-
-        std::sort(renderableEntities.begin(), renderableEntities.end(), [](const RenderableEntity& a, const RenderableEntity& b){
-            return a.sprite.zIndex < b.sprite.zIndex;
-        });
-
-        for (auto entity : renderableEntities)
-        {
-            const auto transform = entity.transform;
-            const auto sprite = entity.sprite;
-
             SDL_Rect srcRect = sprite.srcRect;
 
             SDL_Rect dstRect = {
-                static_cast<int>(transform.position.x - (sprite.isFixed ? 0 : camera.x)),
-                static_cast<int>(transform.position.y - (sprite.isFixed ? 0 : camera.y)),
-                static_cast<int>(sprite.width * transform.scale.x),
-                static_cast<int>(sprite.height * transform.scale.y)};
+                static_cast<int>(transform.position.x - (sprite.data->isFixed ? 0 : camera.x)),
+                static_cast<int>(transform.position.y - (sprite.data->isFixed ? 0 : camera.y)),
+                static_cast<int>(sprite.data->width * transform.scale.x),
+                static_cast<int>(sprite.data->height * transform.scale.y)};
 
             SDL_RenderCopyEx(
                 renderer,
-                assetStore->GetTexture(sprite.assetId),
+                assetStore->GetTexture(sprite.data->assetId),
                 &srcRect,
                 &dstRect,
                 transform.rotation,
@@ -11,9 +11,8 @@ class RenderTextSystem: public System {
             RequireComponent<TextLabelComponent>();
         }
 
-        void Update(SDL_Renderer* renderer, std::unique_ptr<AssetStore>& assetStore, const SDL_Rect& camera) {
-           for(auto entity: GetEntities()) {
-               const auto textLabel = entity.GetComponent<TextLabelComponent>();
+        void Update(const std::unique_ptr<Registry>& registry, SDL_Renderer* renderer, std::unique_ptr<AssetStore>& assetStore, const SDL_Rect& camera) {
+           registry->View<const TextLabelComponent>().Each([&](Entity entity, const TextLabelComponent& textLabel) {
 
                SDL_Surface* surface = TTF_RenderText_Blended(
                    assetStore->GetFont(textLabel.assetId),
@@ -37,6 +36,6 @@ class RenderTextSystem: public System {
                };
 
                SDL_RenderCopy(renderer, texture, NULL, &dstRect);
-           }
+           });
         }
 };
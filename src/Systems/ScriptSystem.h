@@ -34,6 +34,7 @@ void SetEntityPosition(Entity entity, double x, double y) {
         auto& transform = entity.GetComponent<TransformComponent>();
         transform.position.x = x;
         transform.position.y = y;
+        entity.MarkChanged<TransformComponent>();
     } else {
         Logger::Err("Trying to set the position of an entity that has no transform component");
     }
@@ -44,6 +45,7 @@ void SetEntityVelocity(Entity entity, double x, double y) {
         auto& rigidbody = entity.GetComponent<RigidBodyComponent>();
         rigidbody.velocity.x = x;
         rigidbody.velocity.y = y;
+        entity.MarkChanged<RigidBodyComponent>();
     } else {
         Logger::Err("Trying to set the velocity of an entity that has no rigidbody component");
     }
@@ -53,6 +55,7 @@ void SetEntityRotation(Entity entity, double angle) {
     if (entity.HasComponent<TransformComponent>()) {
         auto& transform = entity.GetComponent<TransformComponent>();
         transform.rotation = angle;
+        entity.MarkChanged<TransformComponent>();
     } else {
         Logger::Err("Trying to set the rotation of an entity that has no transform component");
     }
@@ -62,6 +65,7 @@ void SetEntityAnimationFrame(Entity entity, int frame) {
     if (entity.HasComponent<AnimationComponent>()) {
         auto& animation = entity.GetComponent<AnimationComponent>();
         animation.currentFrame = frame;
+        entity.MarkChanged<AnimationComponent>();
     } else {
         Logger::Err("Trying to set the animation frame of an entity that has no animation component");
     }
@@ -72,6 +76,7 @@ void SetProjectileVelocity(Entity entity, double x, double y) {
         auto& projectileEmitter = entity.GetComponent<ProjectileEmitterComponent>();
         projectileEmitter.velocity.x = x;
         projectileEmitter.velocity.y = y;
+        entity.MarkChanged<ProjectileEmitterComponent>();
     } else {
         Logger::Err("Trying to set the projectile velocity of an entity that has no projectile emitter component");
     }
@@ -81,6 +86,11 @@ class ScriptSystem: public System {
     public:
         ScriptSystem() {
             RequireComponent<ScriptComponent>();
+            // (what the Lua bindings can modify)
+            WritesComponent<TransformComponent>();
+            WritesComponent<RigidBodyComponent>();
+            WritesComponent<AnimationComponent>();
+            WritesComponent<ProjectileEmitterComponent>();
         }
 
         void CreateLuaBindings(sol::state& lua) {
@@ -88,8 +98,8 @@ class ScriptSystem: public System {
                 "entity",
                 "get_id", &Entity::GetId,
                 "destroy", &Entity::Kill,
-                "has_tag", &Entity::HasTag,
-                "belongs_to_group", &Entity::BelongsToGroup
+                "has_tag", sol::resolve<bool(const std::string&) const>(&Entity::HasTag),
+                "belongs_to_group", sol::resolve<bool(const std::string&) const>(&Entity::BelongsToGroup)
             );
 
             lua.set_function("get_position", GetEntityPosition);
@@ -101,10 +111,9 @@ class ScriptSystem: public System {
             lua.set_function("set_animation_frame", SetEntityAnimationFrame);
         }
 
-        void Update(double deltaTime, uint32_t ellapsedTime) {
-            for (auto entity: GetEntities()) {
-                const auto script = entity.GetComponent<ScriptComponent>();
+        void Update(const std::unique_ptr<Registry>& registry, double deltaTime, uint32_t ellapsedTime) {
+            registry->View<const ScriptComponent>().Each([deltaTime, ellapsedTime](Entity entity, const ScriptComponent& script) {
                 script.func(entity, deltaTime, ellapsedTime);
-            }
+            });
         }
 };
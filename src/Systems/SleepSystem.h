@@ -0,0 +1,88 @@
+#pragma once
+
+#include "../ECS/ECS.h"
+#include "../Components/TransformComponent.h"
+#include "../Components/SleepComponent.h"
+#include <SDL2/SDL.h>
+#include <algorithm>
+#include <cmath>
+
+// Disables the entities that get far from the camera view and enables them again once the camera
+// comes back. Sleeping entities aren't visited by any system or view; this system only checks on
+// them a few times per second. Anything else can wake an entity early with Entity::Enable().
+class SleepSystem: public System {
+    private:
+        std::vector<Entity> sleepingEntities;
+        std::vector<Entity> entitiesToSleep;
+        double timeUntilCheck = 0.0;
+
+        // Distance from the position to the camera rectangle, 0 inside it
+        static double GetDistanceToCamera(const glm::vec2& position, const SDL_Rect& camera) {
+            const double dx = std::max({camera.x - static_cast<double>(position.x), 0.0, position.x - static_cast<double>(camera.x + camera.w)});
+            const double dy = std::max({camera.y - static_cast<double>(position.y), 0.0, position.y - static_cast<double>(camera.y + camera.h)});
+            return std::sqrt(dx * dx + dy * dy);
+        }
+
+    public:
+        static constexpr double CHECK_INTERVAL = 0.25;
+
+        SleepSystem() {
+            RequireComponent<TransformComponent>();
+            RequireComponent<SleepComponent>();
+            // (enabling and disabling entities is a structural change)
+            RequireExclusiveAccess();
+        }
+
+        void Update(const std::unique_ptr<Registry>& registry, const SDL_Rect& camera, double deltaTime) {
+            timeUntilCheck -= deltaTime;
+            if (timeUntilCheck > 0.0) {
+                return;
+            }
+            timeUntilCheck = CHECK_INTERVAL;
+
+            // Wake the sleepers the camera got close to, and stop tracking the ones killed or woken meanwhile
+            for (size_t i = 0; i < sleepingEntities.size();) {
+                const Entity entity = sleepingEntities[i];
+                bool isAwake = !registry->IsAlive(entity) || registry->IsEntityEnabled(entity);
+                if (!isAwake) {
+                    const auto& transform = registry->GetComponent<TransformComponent>(entity);
+                    const auto& sleep = registry->GetComponent<SleepComponent>(entity);
+                    if (GetDistanceToCamera(transform.position, camera) <= sleep.wakeDistance) {
+                        registry->EnableEntity(entity);
+                        isAwake = true;
+                    }
+                }
+
+                if (isAwake) {
+                    sleepingEntities[i] = sleepingEntities.back();
+                    sleepingEntities.pop_back();
+                } else {
+                    i++;
+                }
+            }
+
+            // (disabling an entity removes it from GetEntities, so collect them first)
+            entitiesToSleep.clear();
+            for (auto entity: GetEntities()) {
+                const auto& transform = registry->GetComponent<TransformComponent>(entity);
+                const auto& sleep = registry->GetComponent<SleepComponent>(entity);
+                if (GetDistanceToCamera(transform.position, camera) > sleep.sleepDistance) {
+                    entitiesToSleep.push_back(entity);
+                }
+            }
+            for (auto entity: entitiesToSleep) {
+                registry->DisableEntity(entity);
+                sleepingEntities.push_back(entity);
+            }
+        }
+
+        // Enables every sleeping entity, e.g. before the level is saved or unloaded
+        void WakeAll(const std::unique_ptr<Registry>& registry) {
+            for (auto entity: sleepingEntities) {
+                if (registry->IsAlive(entity)) {
+                    registry->EnableEntity(entity);
+                }
+            }
+            sleepingEntities.clear();
+        }
+};